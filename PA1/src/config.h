@@ -0,0 +1,28 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+// Options of one partitioning call, main fills them from the command line; each partitioner keeps
+// its own copy, so concurrent calls may run with different options
+struct Config {
+    bool multilevel        = false;  // run the multilevel V-cycle instead of flat FM
+    int coarsest_cell_num  = 200;    // stop coarsening once a level has this few cells
+    double coarsen_ratio   = 0.9;    // stop coarsening when a level shrinks less than this
+    int max_match_net_size = 50;     // nets larger than this are ignored when scoring matches
+    int level_pass_num     = 0;      // FM passes at each projected level of the V-cycle, 0 to run them to convergence
+    unsigned int seed      = 0;      // seed of the random initial partitions and the matching order
+    int start_num          = 1;      // number of independent FM starts
+    int thread_num         = 1;      // number of threads running the starts
+    int pass_thread_num    = 1;      // number of threads of the gain initialization and the rollback in each pass
+    bool stream_init       = false;  // start FM from a streaming LDG pass over the nets instead of an index split
+    bool jet               = false;  // refine with the parallel Jet-style rounds instead of FM
+    int lookahead          = 0;      // break FM gain ties by the level-2 (2) or level-2 and 3 (3) gains, 0 to disable
+    int early_move_num     = 0;      // end a pass after this many moves without improvement, 0 to disable
+    int early_gain_drop    = 0;      // end a pass once the accumulated gain drops this far below its max, 0 to disable
+    int part_num           = 2;      // number of blocks, more than 2 runs recursive bisection
+    bool connectivity      = false;  // minimize the connectivity (lambda - 1) instead of the cut nets in k-way mode
+    bool async_write       = false;  // write the result file on a background thread
+    double time_limit      = 0;      // wall-clock budget of the whole run in seconds, 0 to disable
+    double hgr_b_factor    = 0.1;    // balance factor of .hgr inputs, which do not carry one
+};
+
+#endif  // CONFIG_H
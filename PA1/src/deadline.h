@@ -0,0 +1,35 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <atomic>
+#include <chrono>
+using namespace std;
+
+// Wall-clock budget of one partitioning call, shared by the partitioners working on it: once it is
+// reached every pass stops at its best prefix. Each call has its own, so concurrent calls never interfere.
+class Deadline {
+  public:
+    // constructor and destructor
+    explicit Deadline(double seconds)
+        : end_(chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(seconds))),
+          time_out_(false) {}
+    Deadline(const Deadline&)            = delete;
+    Deadline& operator=(const Deadline&) = delete;
+    ~Deadline() {}
+
+    // Whether the time is up, the clock is no longer read once it is
+    bool isTimeOut() {
+        if (time_out_.load(memory_order_relaxed)) return true;
+        if (chrono::steady_clock::now() < end_) return false;
+        time_out_.store(true, memory_order_relaxed);
+        return true;
+    }
+    // Whether a partitioner was cut off by the budget
+    bool isCutOff() const { return time_out_.load(memory_order_relaxed); }
+
+  private:
+    const chrono::steady_clock::time_point end_;  // end of the budget, set before any thread reads it
+    atomic<bool> time_out_;                       // whether the budget is used up
+};
+
+#endif  // DEADLINE_H
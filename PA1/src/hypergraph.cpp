@@ -0,0 +1,701 @@
+#include "hypergraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <charconv>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <string>
+
+using namespace std;
+
+// The gain buckets take 4 entries per unit of the largest weighted degree, so net weights are bounded:
+// a cell of a net-weighted input may have at most max_weighted_degree, and the total net weight, which
+// bounds the weighted degree of any coarse cell too, at most max_total_net_weight
+constexpr long max_weighted_degree  = 1 << 20;
+constexpr long max_total_net_weight = INT_MAX / 4;
+
+// Scan the next whitespace separated token in place, an empty view means the end of the file
+static string_view nextToken(const char*& pos, const char* end) {
+    while (pos != end && isspace(static_cast<unsigned char>(*pos))) { ++pos; }
+    const char* begin = pos;
+    while (pos != end && !isspace(static_cast<unsigned char>(*pos))) { ++pos; }
+    return string_view(begin, pos - begin);
+}
+
+void Hypergraph::parseInput(const MappedFile& in_file) {
+    const char* pos = in_file.begin();
+    const char* end = in_file.end();
+    // Set balance factor
+    b_factor_ = stod(string(nextToken(pos, end)));
+
+    // Set up whole circuit
+    net_offset_.push_back(0);
+    for (string_view str = nextToken(pos, end); !str.empty(); str = nextToken(pos, end)) {
+        if (str == "NET") {
+            string_view net_name = nextToken(pos, end), cell_name, tmp_cell_name;
+            for (cell_name = nextToken(pos, end); !cell_name.empty(); cell_name = nextToken(pos, end)) {
+                if (cell_name == ";") break;
+                // an seen cell already added to the net
+                if (cell_name == tmp_cell_name) continue;
+                int cell_id = cell_name_2_id_.intern(cell_name, cell_name_);
+                // a newly seen cell
+                if (cell_id == cell_num_) ++cell_num_;
+                net_pin_.push_back(cell_id);
+                tmp_cell_name = cell_name;
+            }
+            // Delete the net if it is a single-pin net
+            if (net_pin_.size() - net_offset_.back() == 1) {
+                net_pin_.pop_back();
+            } else {
+                net_name_.push_back(net_name);
+                net_offset_.push_back(net_pin_.size());
+                ++net_num_;
+            }
+            ++all_net_num_;
+        }
+    }
+    cell_name_.shrink();
+    net_name_.shrink();
+    cell_weight_.assign(cell_num_, 1);
+    total_weight_ = cell_num_;
+    net_weight_.assign(net_num_, 1);
+    mergeNets();
+    initCellPin();
+}
+
+void Hypergraph::mergeNets() {
+    // Nets on the same cell set are merged into the one of the smallest id, which takes their total
+    // weight, so the cut is unchanged. The sorted cell lists are hashed, equal hashes are compared.
+    vector<int> sorted_pin(net_pin_);
+    vector<uint64_t> key(net_num_);
+    for (int net_id = 0; net_id < net_num_; ++net_id) {
+        auto begin = sorted_pin.begin() + net_offset_[net_id], end = sorted_pin.begin() + net_offset_[net_id + 1];
+        sort(begin, end);
+        uint64_t h = 14695981039346656037ULL;
+        for (auto it = begin; it != end; ++it) { h = (h ^ uint64_t(*it)) * 1099511628211ULL; }
+        key[net_id] = h;
+    }
+    auto same_cells = [&](int a, int b) {
+        return equal(sorted_pin.begin() + net_offset_[a], sorted_pin.begin() + net_offset_[a + 1], sorted_pin.begin() + net_offset_[b],
+                     sorted_pin.begin() + net_offset_[b + 1]);
+    };
+    vector<int> order(net_num_);
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](int a, int b) { return key[a] < key[b] || (key[a] == key[b] && a < b); });
+    vector<char> merged(net_num_, 0);
+    int merged_num = 0;
+    for (int i = 0, j = 0; i < net_num_; i = j) {
+        while (j < net_num_ && key[order[j]] == key[order[i]]) { ++j; }
+        for (int a = i; a < j; ++a) {
+            if (merged[order[a]]) continue;
+            for (int b = a + 1; b < j; ++b) {
+                if (merged[order[b]] || !same_cells(order[a], order[b])) continue;
+                merged[order[b]] = true;
+                assert(long(net_weight_[order[a]]) + net_weight_[order[b]] <= max_total_net_weight);
+                net_weight_[order[a]] += net_weight_[order[b]];
+                ++merged_num;
+            }
+        }
+    }
+    if (merged_num == 0) return;
+
+    // Keep the other nets in id order with their pins in input order
+    vector<int> net_offset(1, 0), net_pin, net_weight;
+    NamePool net_name;
+    for (int net_id = 0; net_id < net_num_; ++net_id) {
+        if (merged[net_id]) continue;
+        IdRange net_cell_list = getCellList(net_id);
+        net_pin.insert(net_pin.end(), net_cell_list.begin(), net_cell_list.end());
+        net_offset.push_back(net_pin.size());
+        net_weight.push_back(net_weight_[net_id]);
+        net_name.push_back(net_name_[net_id]);
+    }
+    net_num_ -= merged_num;
+    net_offset_.swap(net_offset);
+    net_pin_.swap(net_pin);
+    net_weight_.swap(net_weight);
+    net_name_.swap(net_name);
+}
+
+// Skip the blanks inside a line
+static void skipBlank(const char*& pos, const char* end) {
+    while (pos != end && (*pos == ' ' || *pos == '\t' || *pos == '\r')) { ++pos; }
+}
+
+// Move to the next line that is neither empty nor a % comment, false at the end of the file
+static bool nextLine(const char*& pos, const char* end) {
+    while (true) {
+        skipBlank(pos, end);
+        if (pos == end) return false;
+        if (*pos != '\n' && *pos != '%') return true;
+        while (pos != end && *pos != '\n') { ++pos; }
+        if (pos != end) ++pos;
+    }
+}
+
+// Read the next integer of the current line, false if the line has no more
+static bool nextInt(const char*& pos, const char* end, long& value) {
+    skipBlank(pos, end);
+    from_chars_result result = from_chars(pos, end, value);
+    if (result.ec != errc()) return false;
+    pos = result.ptr;
+    return true;
+}
+
+// Step over the end of the current line, false if anything but blanks is left on it
+static bool endLine(const char*& pos, const char* end) {
+    skipBlank(pos, end);
+    if (pos == end) return true;
+    if (*pos != '\n') return false;
+    ++pos;
+    return true;
+}
+
+static void pushIndexName(NamePool& names, long index) {
+    char str[24];
+    names.push_back(string_view(str, to_chars(str, str + sizeof(str), index).ptr - str));
+}
+
+Hypergraph* Hypergraph::loadHgr(const MappedFile& in_file, double b_factor) {
+    const char* pos = in_file.begin();
+    const char* end = in_file.end();
+    // Header: net number, vertex number and an optional format, 1 for net weights, 10 for vertex weights, 11 for both
+    long net_num, cell_num, format = 0;
+    if (!nextLine(pos, end) || !nextInt(pos, end, net_num) || !nextInt(pos, end, cell_num)) return nullptr;
+    nextInt(pos, end, format);
+    if (!endLine(pos, end) || net_num < 0 || cell_num < 0 || cell_num > INT_MAX || (format != 0 && format != 1 && format != 10 && format != 11))
+        return nullptr;
+    bool net_weighted  = format % 10 == 1;
+    bool cell_weighted = format / 10 == 1;
+
+    // The cells are named by their 1-based index, which the partition file is written in
+    Hypergraph* graph = new Hypergraph(b_factor);
+    graph->hgr_       = true;
+    graph->cell_num_  = cell_num;
+    graph->cell_name_.reserve(cell_num, 8 * size_t(cell_num));
+    for (long cell_id = 0; cell_id < cell_num; ++cell_id) { pushIndexName(graph->cell_name_, cell_id + 1); }
+    graph->net_offset_.push_back(0);
+    long total_net_weight = 0;
+    for (long net_id = 0; net_id < net_num; ++net_id) {
+        long net_weight = 1, cell = 1;
+        if (!nextLine(pos, end) || (net_weighted && (!nextInt(pos, end, net_weight) || net_weight < 1 || net_weight > INT_MAX))) {
+            delete graph;
+            return nullptr;
+        }
+        int net_begin = graph->net_pin_.size();
+        while (nextInt(pos, end, cell)) {
+            if (cell < 1 || cell > cell_num) break;
+            // a seen cell already added to the net, as in the NET format
+            if (int(graph->net_pin_.size()) != net_begin && graph->net_pin_.back() == cell - 1) continue;
+            graph->net_pin_.push_back(cell - 1);
+        }
+        if ((cell < 1 || cell > cell_num) || !endLine(pos, end)) {
+            delete graph;
+            return nullptr;
+        }
+        ++graph->all_net_num_;
+        // Delete the net if it is a single-pin net
+        if (int(graph->net_pin_.size()) - net_begin < 2) {
+            graph->net_pin_.resize(net_begin);
+            continue;
+        }
+        total_net_weight += net_weight;
+        if (total_net_weight > max_total_net_weight) {
+            delete graph;
+            return nullptr;
+        }
+        pushIndexName(graph->net_name_, net_id + 1);
+        graph->net_offset_.push_back(graph->net_pin_.size());
+        graph->net_weight_.push_back(net_weight);
+        ++graph->net_num_;
+    }
+    graph->cell_weight_.assign(cell_num, 1);
+    long total_weight = cell_num;
+    if (cell_weighted) {
+        total_weight = 0;
+        for (int& cell_weight : graph->cell_weight_) {
+            long weight;
+            if (!nextLine(pos, end) || !nextInt(pos, end, weight) || weight < 0 || weight > INT_MAX || !endLine(pos, end)) {
+                delete graph;
+                return nullptr;
+            }
+            cell_weight = weight;
+            total_weight += weight;
+        }
+    }
+    if (nextLine(pos, end) || total_weight > INT_MAX) {
+        delete graph;
+        return nullptr;
+    }
+    graph->total_weight_ = total_weight;
+    graph->mergeNets();
+    graph->initCellPin();
+    if (net_weighted && graph->max_degree_ > max_weighted_degree) {
+        delete graph;
+        return nullptr;
+    }
+    return graph;
+}
+
+Hypergraph* Hypergraph::build(int cell_num, const vector<int>& net_offset, const vector<int>& net_pin, const vector<int>& cell_weight,
+                              const vector<int>& net_weight, double b_factor) {
+    int net_num = int(net_offset.size()) - 1;
+    if (cell_num < 0 || net_num < 0 || net_offset[0] != 0 || net_offset[net_num] != int(net_pin.size())) return nullptr;
+    if ((!cell_weight.empty() && int(cell_weight.size()) != cell_num) || (!net_weight.empty() && int(net_weight.size()) != net_num)) return nullptr;
+    long total_net_weight = 0;
+    for (int net_id = 0; net_id < net_num; ++net_id) {
+        if (net_offset[net_id] > net_offset[net_id + 1] || (!net_weight.empty() && net_weight[net_id] < 1)) return nullptr;
+        total_net_weight += net_weight.empty() ? 1 : net_weight[net_id];
+    }
+    if (total_net_weight > max_total_net_weight) return nullptr;
+    for (int cell_id : net_pin) {
+        if (cell_id < 0 || cell_id >= cell_num) return nullptr;
+    }
+    long total_weight = cell_num;
+    if (!cell_weight.empty()) {
+        total_weight = 0;
+        for (int weight : cell_weight) {
+            if (weight < 0) return nullptr;
+            total_weight += weight;
+        }
+        if (total_weight > INT_MAX) return nullptr;
+    }
+
+    Hypergraph* graph    = new Hypergraph(b_factor);
+    graph->cell_num_     = cell_num;
+    graph->all_net_num_  = net_num;
+    graph->total_weight_ = total_weight;
+    if (cell_weight.empty())
+        graph->cell_weight_.assign(cell_num, 1);
+    else
+        graph->cell_weight_ = cell_weight;
+    for (int cell_id = 0; cell_id < cell_num; ++cell_id) { pushIndexName(graph->cell_name_, cell_id + 1); }
+    graph->net_pin_.reserve(net_pin.size());
+    graph->net_offset_.push_back(0);
+    for (int net_id = 0; net_id < net_num; ++net_id) {
+        int net_begin = graph->net_pin_.size();
+        for (int i = net_offset[net_id]; i < net_offset[net_id + 1]; ++i) {
+            // a seen cell already added to the net, as in the NET format
+            if (int(graph->net_pin_.size()) != net_begin && graph->net_pin_.back() == net_pin[i]) continue;
+            graph->net_pin_.push_back(net_pin[i]);
+        }
+        // Delete the net if it is a single-pin net
+        if (int(graph->net_pin_.size()) - net_begin < 2) {
+            graph->net_pin_.resize(net_begin);
+            continue;
+        }
+        pushIndexName(graph->net_name_, net_id + 1);
+        graph->net_offset_.push_back(graph->net_pin_.size());
+        graph->net_weight_.push_back(net_weight.empty() ? 1 : net_weight[net_id]);
+        ++graph->net_num_;
+    }
+    graph->mergeNets();
+    graph->initCellPin();
+    if (!net_weight.empty() && graph->max_degree_ > max_weighted_degree) {
+        delete graph;
+        return nullptr;
+    }
+    return graph;
+}
+
+int Hypergraph::getHgrVertex(int cell_id) const {
+    string_view name = cell_name_[cell_id];
+    int index        = 0;
+    from_chars(name.data(), name.data() + name.size(), index);
+    return index - 1;
+}
+
+bool Hypergraph::parseResult(const MappedFile& in_file, vector<int>& cell_part) {
+    // A hypergraph loaded from a cache has no name table yet
+    if (cell_name_2_id_.size() != cell_num_) cell_name_2_id_.assign(cell_name_);
+    const char* pos = in_file.begin();
+    const char* end = in_file.end();
+    cell_part.assign(cell_num_, -1);
+    int group_num = 0;
+    for (string_view str = nextToken(pos, end); !str.empty(); str = nextToken(pos, end)) {
+        if (str != "G1" && str != "G2") continue;
+        int part = str == "G2";
+        // Skip the group size, the names of removed cells are ignored
+        nextToken(pos, end);
+        for (string_view cell_name = nextToken(pos, end); !cell_name.empty() && cell_name != ";"; cell_name = nextToken(pos, end)) {
+            int cell_id = cell_name_2_id_.find(cell_name, cell_name_);
+            if (cell_id != -1) cell_part[cell_id] = part;
+        }
+        ++group_num;
+    }
+    return group_num == 2;
+}
+
+// Binary cache layout: CacheHeader followed by cell_weight_, net_weight_, net_offset_, net_pin_, cell_offset_,
+// cell_pin_, then the cell and the net names, each as num + 1 offsets and the name bytes,
+// all in native byte order
+constexpr char cache_magic[4]    = {'F', 'M', 'H', 'G'};
+constexpr uint32_t cache_version = 3;
+
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t net_num, all_net_num, cell_num, total_weight, max_degree, pin_num, hgr;
+    double b_factor;
+    int64_t cell_name_size, net_name_size;  // total bytes of the cell and net names
+};
+
+template <class T>
+static void writeArray(ostream& out, const T* data, size_t num) {
+    out.write(reinterpret_cast<const char*>(data), num * sizeof(T));
+}
+
+template <class T>
+static void readArray(const char*& pos, vector<T>& array, size_t num) {
+    array.resize(num);
+    memcpy(array.data(), pos, num * sizeof(T));
+    pos += num * sizeof(T);
+}
+
+// Write the names back to back, with num + 1 offsets in front
+static void writeNames(ostream& out, const NamePool& names) {
+    vector<int64_t> offset(1, 0);
+    for (int id = 0; id < names.size(); ++id) { offset.push_back(offset.back() + names[id].size()); }
+    writeArray(out, offset.data(), offset.size());
+    for (int id = 0; id < names.size(); ++id) { out.write(names[id].data(), names[id].size()); }
+}
+
+// Read num names of size bytes in total, false if their offsets do not add up to it
+static bool readNames(const char*& pos, NamePool& names, size_t num, int64_t size) {
+    vector<int64_t> offset;
+    readArray(pos, offset, num + 1);
+    if (offset[0] != 0 || offset[num] != size) return false;
+    for (size_t i = 0; i < num; ++i) {
+        if (offset[i] > offset[i + 1]) return false;
+    }
+    names.clear();
+    names.reserve(num, offset[num]);
+    for (size_t i = 0; i < num; ++i) { names.push_back(string_view(pos + offset[i], offset[i + 1] - offset[i])); }
+    pos += offset[num];
+    return true;
+}
+
+Hypergraph* Hypergraph::loadCache(const MappedFile& in_file) {
+    CacheHeader header;
+    if (in_file.size() < sizeof(header)) return nullptr;
+    memcpy(&header, in_file.begin(), sizeof(header));
+    if (memcmp(header.magic, cache_magic, 4) != 0 || header.version != cache_version) return nullptr;
+    if (header.net_num < 0 || header.cell_num < 0 || header.pin_num < 0 || header.cell_name_size < 0 || header.net_name_size < 0) return nullptr;
+    if (header.max_degree < 0 || header.max_degree > max_total_net_weight) return nullptr;
+    // The sizes must add up to the file exactly, so a truncated cache is rejected before reading
+    size_t int_num  = size_t(header.cell_num) + header.net_num + (header.net_num + 1) + header.pin_num + (header.cell_num + 1) + header.pin_num;
+    size_t name_num = size_t(header.cell_num + 1) + (header.net_num + 1);
+    if (in_file.size() != sizeof(header) + int_num * sizeof(int) + name_num * sizeof(int64_t) + header.cell_name_size + header.net_name_size)
+        return nullptr;
+
+    Hypergraph* graph    = new Hypergraph(header.b_factor);
+    graph->net_num_      = header.net_num;
+    graph->all_net_num_  = header.all_net_num;
+    graph->cell_num_     = header.cell_num;
+    graph->total_weight_ = header.total_weight;
+    graph->max_degree_   = header.max_degree;
+    graph->hgr_          = header.hgr;
+    const char* pos      = in_file.begin() + sizeof(header);
+    readArray(pos, graph->cell_weight_, header.cell_num);
+    readArray(pos, graph->net_weight_, header.net_num);
+    readArray(pos, graph->net_offset_, header.net_num + 1);
+    readArray(pos, graph->net_pin_, header.pin_num);
+    readArray(pos, graph->cell_offset_, header.cell_num + 1);
+    readArray(pos, graph->cell_pin_, header.pin_num);
+    if (!readNames(pos, graph->cell_name_, header.cell_num, header.cell_name_size) ||
+        !readNames(pos, graph->net_name_, header.net_num, header.net_name_size) || !graph->checkCache()) {
+        delete graph;
+        return nullptr;
+    }
+    return graph;
+}
+
+bool Hypergraph::checkCache() const {
+    // Offsets start at 0, never decrease and end at the pin number, so every list lies in the pin arrays
+    auto valid_offset = [&](const vector<int>& offset) {
+        if (offset.front() != 0 || offset.back() != int(net_pin_.size())) return false;
+        for (size_t i = 0; i + 1 < offset.size(); ++i) {
+            if (offset[i] > offset[i + 1]) return false;
+        }
+        return true;
+    };
+    if (!valid_offset(net_offset_) || !valid_offset(cell_offset_)) return false;
+    for (int cell_id : net_pin_) {
+        if (cell_id < 0 || cell_id >= cell_num_) return false;
+    }
+    // The cell lists are the transpose of the net lists, nets in increasing id order as initCellPin
+    // builds them, so every cell_pin_ entry is a valid net and the gains stay within max_degree_
+    vector<int> fill_pos(cell_offset_.begin(), cell_offset_.end() - 1);
+    vector<long> degree(cell_num_, 0);
+    for (int net_id = 0; net_id < net_num_; ++net_id) {
+        if (net_weight_[net_id] < 1) return false;
+        for (int cell_id : getCellList(net_id)) {
+            if (fill_pos[cell_id] == cell_offset_[cell_id + 1] || cell_pin_[fill_pos[cell_id]++] != net_id) return false;
+            degree[cell_id] += net_weight_[net_id];
+        }
+    }
+    if (max_degree_ != (cell_num_ ? *max_element(degree.begin(), degree.end()) : 0)) return false;
+    long total_weight = 0;
+    for (int weight : cell_weight_) {
+        if (weight < 0) return false;
+        total_weight += weight;
+    }
+    return total_weight == total_weight_;
+}
+
+bool Hypergraph::writeCache(const char* file_name) const {
+    ofstream out(file_name, ios::binary);
+    if (!out) return false;
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, cache_magic, 4);
+    header.version        = cache_version;
+    header.net_num        = net_num_;
+    header.all_net_num    = all_net_num_;
+    header.cell_num       = cell_num_;
+    header.total_weight   = total_weight_;
+    header.max_degree     = max_degree_;
+    header.hgr            = hgr_;
+    header.pin_num        = net_pin_.size();
+    header.b_factor       = b_factor_;
+    header.cell_name_size = cell_name_.byteSize();
+    header.net_name_size  = net_name_.byteSize();
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeArray(out, cell_weight_.data(), cell_weight_.size());
+    writeArray(out, net_weight_.data(), net_weight_.size());
+    writeArray(out, net_offset_.data(), net_offset_.size());
+    writeArray(out, net_pin_.data(), net_pin_.size());
+    writeArray(out, cell_offset_.data(), cell_offset_.size());
+    writeArray(out, cell_pin_.data(), cell_pin_.size());
+    writeNames(out, cell_name_);
+    writeNames(out, net_name_);
+    return bool(out);
+}
+
+void Hypergraph::initCellPin() {
+    // Transpose the net to cell CSR, nets of a cell stay in increasing id order
+    cell_offset_.assign(cell_num_ + 1, 0);
+    for (int cell_id : net_pin_) { ++cell_offset_[cell_id + 1]; }
+    for (int cell_id = 0; cell_id < cell_num_; ++cell_id) { cell_offset_[cell_id + 1] += cell_offset_[cell_id]; }
+    cell_pin_.resize(net_pin_.size());
+    vector<int> fill_pos(cell_offset_.begin(), cell_offset_.end() - 1);
+    vector<long> degree(cell_num_, 0);
+    for (int net_id = 0; net_id < net_num_; ++net_id) {
+        for (int cell_id : getCellList(net_id)) {
+            cell_pin_[fill_pos[cell_id]++] = net_id;
+            degree[cell_id] += net_weight_[net_id];
+        }
+    }
+    long max_degree = 0;
+    for (int cell_id = 0; cell_id < cell_num_; ++cell_id) { max_degree = max(max_degree, degree[cell_id]); }
+    assert(max_degree <= max_total_net_weight);
+    max_degree_ = max_degree;
+}
+
+Hypergraph* Hypergraph::coarsen(vector<int>& cluster_id, mt19937& rng, int max_match_net_size) const {
+    // Heavy-edge matching: visit cells in random order and pair each one with the
+    // unmatched neighbor of the highest connectivity, sum of 1 / (|net| - 1)
+    int max_weight = max(1, int(b_factor_ * total_weight_ / 2));
+    vector<int> order(cell_num_);
+    iota(order.begin(), order.end(), 0);
+    shuffle(order.begin(), order.end(), rng);
+
+    int coarse_num = 0;
+    cluster_id.assign(cell_num_, -1);
+    vector<double> score(cell_num_, 0);
+    vector<int> neighbors;
+    for (int cell_id : order) {
+        if (cluster_id[cell_id] != -1) continue;
+        int weight = cell_weight_[cell_id];
+        for (int net_id : getNetList(cell_id)) {
+            IdRange net_cell_list = getCellList(net_id);
+            int net_size          = net_cell_list.size();
+            if (net_size > max_match_net_size) continue;
+            double net_score = double(net_weight_[net_id]) / (net_size - 1);
+            for (int neighbor_id : net_cell_list) {
+                if (neighbor_id == cell_id || cluster_id[neighbor_id] != -1) continue;
+                if (weight + cell_weight_[neighbor_id] > max_weight) continue;
+                if (score[neighbor_id] == 0) neighbors.push_back(neighbor_id);
+                score[neighbor_id] += net_score;
+            }
+        }
+        int match_id      = -1;
+        double best_score = 0;
+        for (int neighbor_id : neighbors) {
+            score[neighbor_id] /= cell_weight_[neighbor_id];
+            if (score[neighbor_id] > best_score) {
+                best_score = score[neighbor_id];
+                match_id   = neighbor_id;
+            }
+            score[neighbor_id] = 0;
+        }
+        neighbors.clear();
+        cluster_id[cell_id] = coarse_num;
+        if (match_id != -1) cluster_id[match_id] = coarse_num;
+        ++coarse_num;
+    }
+
+    // Build the coarse hypergraph
+    Hypergraph* coarse = new Hypergraph(b_factor_);
+    coarse->cell_num_     = coarse_num;
+    coarse->total_weight_ = total_weight_;
+    coarse->cell_weight_.assign(coarse_num, 0);
+    // A coarse cell is named after its first fine cell
+    vector<int> first_cell(coarse_num);
+    for (int cell_id = cell_num_ - 1; cell_id >= 0; --cell_id) {
+        coarse->cell_weight_[cluster_id[cell_id]] += cell_weight_[cell_id];
+        first_cell[cluster_id[cell_id]] = cell_id;
+    }
+    for (int cell_id : first_cell) { coarse->cell_name_.push_back(cell_name_[cell_id]); }
+
+    // Nets inside a single cluster can never be cut, so they are dropped
+    vector<int>& coarse_pin = coarse->net_pin_;
+    coarse->net_offset_.push_back(0);
+    for (int net_id = 0; net_id < net_num_; ++net_id) {
+        int net_begin = coarse_pin.size();
+        for (int cell_id : getCellList(net_id)) { coarse_pin.push_back(cluster_id[cell_id]); }
+        sort(coarse_pin.begin() + net_begin, coarse_pin.end());
+        coarse_pin.erase(unique(coarse_pin.begin() + net_begin, coarse_pin.end()), coarse_pin.end());
+        if (coarse_pin.size() - net_begin < 2) {
+            coarse_pin.resize(net_begin);
+            continue;
+        }
+        coarse->net_name_.push_back(net_name_[net_id]);
+        coarse->net_offset_.push_back(coarse_pin.size());
+        coarse->net_weight_.push_back(net_weight_[net_id]);
+        ++coarse->net_num_;
+    }
+    coarse->all_net_num_ = coarse->net_num_;
+    coarse->mergeNets();
+    coarse->initCellPin();
+    return coarse;
+}
+
+Hypergraph* Hypergraph::extract(const vector<int>& cell_list, bool split_net) const {
+    Hypergraph* sub = new Hypergraph(b_factor_);
+    vector<int> sub_id(cell_num_, -1);
+    for (int cell_id : cell_list) {
+        sub_id[cell_id] = sub->cell_num_++;
+        sub->total_weight_ += cell_weight_[cell_id];
+        sub->cell_weight_.push_back(cell_weight_[cell_id]);
+        sub->cell_name_.push_back(cell_name_[cell_id]);
+    }
+
+    // A net leaving the cell list is already cut, so it is dropped for the cut-net objective,
+    // and split to its cells inside for the connectivity one, where every extra block still counts
+    vector<int>& sub_pin = sub->net_pin_;
+    sub->net_offset_.push_back(0);
+    for (int net_id = 0; net_id < net_num_; ++net_id) {
+        int net_begin = sub_pin.size();
+        bool inside   = true;
+        for (int cell_id : getCellList(net_id)) {
+            if (sub_id[cell_id] == -1)
+                inside = false;
+            else
+                sub_pin.push_back(sub_id[cell_id]);
+        }
+        if ((!inside && !split_net) || sub_pin.size() - net_begin < 2) {
+            sub_pin.resize(net_begin);
+            continue;
+        }
+        sub->net_name_.push_back(net_name_[net_id]);
+        sub->net_offset_.push_back(sub_pin.size());
+        sub->net_weight_.push_back(net_weight_[net_id]);
+        ++sub->net_num_;
+    }
+    sub->all_net_num_ = sub->net_num_;
+    sub->mergeNets();
+    sub->initCellPin();
+    return sub;
+}
+
+void Hypergraph::reorder() {
+    // Cuthill-McKee order: a breadth-first search over the nets, each component starting from its
+    // lowest degree cell. Nets are numbered as the search reaches them, so the cells and the nets
+    // visited together get nearby ids.
+    vector<int> start_order(cell_num_);
+    iota(start_order.begin(), start_order.end(), 0);
+    stable_sort(start_order.begin(), start_order.end(), [&](int a, int b) { return getNetList(a).size() < getNetList(b).size(); });
+    vector<int> cell_order, net_order;  // old ids in their new order
+    vector<char> cell_seen(cell_num_, 0), net_seen(net_num_, 0);
+    cell_order.reserve(cell_num_);
+    net_order.reserve(net_num_);
+    for (int start_id : start_order) {
+        if (cell_seen[start_id]) continue;
+        cell_seen[start_id] = true;
+        cell_order.push_back(start_id);
+        for (size_t head = cell_order.size() - 1; head < cell_order.size(); ++head) {
+            for (int net_id : getNetList(cell_order[head])) {
+                if (net_seen[net_id]) continue;
+                net_seen[net_id] = true;
+                net_order.push_back(net_id);
+                for (int cell_id : getCellList(net_id)) {
+                    if (cell_seen[cell_id]) continue;
+                    cell_seen[cell_id] = true;
+                    cell_order.push_back(cell_id);
+                }
+            }
+        }
+    }
+    // Pinless nets are never reached, they keep their relative order at the end
+    for (int net_id = 0; net_id < net_num_; ++net_id) {
+        if (!net_seen[net_id]) net_order.push_back(net_id);
+    }
+    assert(int(cell_order.size()) == cell_num_ && int(net_order.size()) == net_num_);
+
+    vector<int> new_cell_id(cell_num_);
+    for (int cell_id = 0; cell_id < cell_num_; ++cell_id) { new_cell_id[cell_order[cell_id]] = cell_id; }
+    NamePool cell_name, net_name;
+    cell_name.reserve(cell_num_, cell_name_.byteSize());
+    net_name.reserve(net_num_, net_name_.byteSize());
+    vector<int> cell_weight(cell_num_);
+    for (int cell_id = 0; cell_id < cell_num_; ++cell_id) {
+        cell_name.push_back(cell_name_[cell_order[cell_id]]);
+        cell_weight[cell_id] = cell_weight_[cell_order[cell_id]];
+    }
+    vector<int> net_offset(1, 0), net_pin, net_weight;
+    net_pin.reserve(net_pin_.size());
+    for (int net_id : net_order) {
+        for (int cell_id : getCellList(net_id)) { net_pin.push_back(new_cell_id[cell_id]); }
+        net_offset.push_back(net_pin.size());
+        net_weight.push_back(net_weight_[net_id]);
+        net_name.push_back(net_name_[net_id]);
+    }
+    cell_name_.swap(cell_name);
+    cell_weight_.swap(cell_weight);
+    net_offset_.swap(net_offset);
+    net_pin_.swap(net_pin);
+    net_weight_.swap(net_weight);
+    net_name_.swap(net_name);
+    // The name table is rebuilt on its next use
+    cell_name_2_id_ = NameTable();
+    initCellPin();
+}
+
+void Hypergraph::reportNet() const {
+    // This function will not report single-pin nets
+    cout << "Number of nets: " << net_num_ << "\n";
+    for (int net_id = 0; net_id < net_num_; ++net_id) {
+        cout << setw(8) << net_name_[net_id] << ": ";
+        for (int cell_id : getCellList(net_id)) { cout << setw(8) << cell_name_[cell_id] << " "; }
+        cout << "\n";
+    }
+    return;
+}
+
+void Hypergraph::reportCell() const {
+    cout << "Number of cells: " << cell_num_ << "\n";
+    for (int cell_id = 0; cell_id < cell_num_; ++cell_id) {
+        cout << setw(8) << cell_name_[cell_id] << ": ";
+        for (int net_id : getNetList(cell_id)) { cout << setw(8) << net_name_[net_id] << " "; }
+        cout << "\n";
+    }
+    return;
+}
@@ -0,0 +1,116 @@
+#ifndef HYPERGRAPH_H
+#define HYPERGRAPH_H
+
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+#include "name_pool.h"
+#include "name_table.h"
+using namespace std;
+
+// View of a contiguous id list inside the CSR arrays
+class IdRange {
+  public:
+    IdRange(const int* begin, const int* end) : begin_(begin), end_(end) {}
+
+    const int* begin() const { return begin_; }
+    const int* end() const { return end_; }
+    int size() const { return end_ - begin_; }
+    int operator[](int i) const { return begin_[i]; }
+
+  private:
+    const int* begin_;
+    const int* end_;
+};
+
+class Hypergraph {
+  public:
+    // constructor and destructor
+    // The names are copied into the name pools, so in_file can be closed once it is parsed
+    Hypergraph(const MappedFile& in_file)
+        : net_num_(0), all_net_num_(0), cell_num_(0), total_weight_(0), max_degree_(0), b_factor_(0), hgr_(false) {
+        parseInput(in_file);
+    }
+    ~Hypergraph() {}
+
+    // basic access methods
+    int getNetNum() const { return net_num_; }
+    int getAllNetNum() const { return all_net_num_; }
+    int getCellNum() const { return cell_num_; }
+    int getTotalWeight() const { return total_weight_; }
+    int getMaxDegree() const { return max_degree_; }
+    double getBFactor() const { return b_factor_; }
+    bool isHgr() const { return hgr_; }
+    int getCellWeight(int cell_id) const { return cell_weight_[cell_id]; }
+    int getNetWeight(int net_id) const { return net_weight_[net_id]; }
+    string_view getCellName(int cell_id) const { return cell_name_[cell_id]; }
+    string_view getNetName(int net_id) const { return net_name_[net_id]; }
+    IdRange getNetList(int cell_id) const { return IdRange(cell_pin_.data() + cell_offset_[cell_id], cell_pin_.data() + cell_offset_[cell_id + 1]); }
+    IdRange getCellList(int net_id) const { return IdRange(net_pin_.data() + net_offset_[net_id], net_pin_.data() + net_offset_[net_id + 1]); }
+    // 0-based vertex index in an hMETIS input, whose cells are named by their 1-based index
+    int getHgrVertex(int cell_id) const;
+
+    // modify method
+    void setBFactor(double b_factor) { b_factor_ = b_factor; }
+
+    // multilevel method
+    // Nets of more than max_match_net_size cells are ignored when scoring the matches
+    Hypergraph* coarsen(vector<int>& cluster_id, mt19937& rng, int max_match_net_size) const;
+
+    // Read the groups G1 and G2 of a result file into cell_part, -1 for a cell in neither of them
+    bool parseResult(const MappedFile& in_file, vector<int>& cell_part);
+
+    // binary cache methods
+    static Hypergraph* loadCache(const MappedFile& in_file);
+    bool writeCache(const char* file_name) const;
+
+    // hMETIS .hgr reader, nullptr if in_file is malformed; the format carries no balance factor, so it is b_factor
+    static Hypergraph* loadHgr(const MappedFile& in_file, double b_factor);
+
+    // In-memory builder for library use: net i holds the cells net_pin[net_offset[i] .. net_offset[i + 1]),
+    // empty weight vectors mean unit weights, cells are named by their 1-based index; nullptr if inconsistent
+    static Hypergraph* build(int cell_num, const vector<int>& net_offset, const vector<int>& net_pin, const vector<int>& cell_weight,
+                             const vector<int>& net_weight, double b_factor);
+
+    // k-way method: sub-hypergraph induced by cell_list, cell i of it is cell_list[i]
+    Hypergraph* extract(const vector<int>& cell_list, bool split_net) const;
+
+    // Renumber the cells and the nets in breadth-first order for memory locality, the names move
+    // with their cells so the result is still written by name
+    void reorder();
+
+    // member functions about reporting
+    void reportNet() const;
+    void reportCell() const;
+
+  private:
+    // Coarse level constructor
+    Hypergraph(double b_factor)
+        : net_num_(0), all_net_num_(0), cell_num_(0), total_weight_(0), max_degree_(0), b_factor_(b_factor), hgr_(false) {}
+
+    void parseInput(const MappedFile& in_file);
+    void mergeNets();
+    void initCellPin();
+    bool checkCache() const;
+
+    int net_num_;                    // number of non-single-pin nets
+    int all_net_num_;                // number of all nets
+    int cell_num_;                   // number of cells
+    int total_weight_;               // total weight of cells
+    int max_degree_;                 // maximum total net weight of a cell, which bounds its gain
+    double b_factor_;                // the balance factor to be met
+    bool hgr_;                       // whether the input was an hMETIS file
+    NamePool net_name_;              // name of each net
+    NamePool cell_name_;             // name of each cell
+    vector<int> cell_weight_;        // weight of each cell (number of merged cells in a coarse level)
+    vector<int> net_weight_;         // weight of each net (number of merged identical nets)
+    vector<int> net_offset_;         // start of each net in net_pin_, net_num_ + 1 entries
+    vector<int> net_pin_;            // cells of all nets, net by net
+    vector<int> cell_offset_;        // start of each cell in cell_pin_, cell_num_ + 1 entries
+    vector<int> cell_pin_;           // nets of all cells, cell by cell
+    NameTable cell_name_2_id_;       // mapping from cell name to id
+};
+
+#endif  // HYPERGRAPH_H
@@ -0,0 +1,134 @@
+#include "kway_partitioner.h"
+
+#include <cmath>
+#include <iostream>
+#include <numeric>
+
+#include "partitioner.h"
+using namespace std;
+
+void KWayPartitioner::run() {
+    // A block goes through at most depth bisections, each of them may lose a (1 - b_factor_)
+    // share, so the blocks together still keep (1 - b) of their W / k target
+    int depth = 0;
+    while ((1 << depth) < part_num_) { ++depth; }
+    b_factor_ = 1 - pow(1 - graph_.getBFactor(), 1.0 / depth);
+
+    block_.assign(graph_.getCellNum(), 0);
+    vector<int> cell_ids(graph_.getCellNum());
+    iota(cell_ids.begin(), cell_ids.end(), 0);
+    bisect(graph_, cell_ids, 0, part_num_);
+    evaluate();
+}
+
+void KWayPartitioner::bisect(const Hypergraph& graph, const vector<int>& cell_ids, int first_block, int part_num) {
+    // Part A(0) takes the larger half of the blocks and the matching share of the weight
+    int sub_part_num[2]      = {(part_num + 1) / 2, part_num / 2};
+    double ratio             = double(sub_part_num[0]) / part_num;
+    Partitioner* partitioner = Partitioner::multiStartPartition(graph, b_factor_, ratio, config_, deadline_);
+    vector<int> sub_cell_list[2];  // cells of each part, as ids of graph
+    vector<int> sub_cell_ids[2];   // cells of each part, as ids of graph_
+    for (int cell_id = 0; cell_id < graph.getCellNum(); ++cell_id) {
+        bool part = partitioner->getPart(cell_id);
+        sub_cell_list[part].push_back(cell_id);
+        sub_cell_ids[part].push_back(cell_ids[cell_id]);
+    }
+    delete partitioner;
+
+    for (int part = 0; part < 2; ++part) {
+        int sub_first_block = first_block + part * sub_part_num[0];
+        if (sub_part_num[part] == 1) {
+            for (int cell_id : sub_cell_ids[part]) { block_[cell_id] = sub_first_block; }
+            continue;
+        }
+        Hypergraph* sub_graph = graph.extract(sub_cell_list[part], config_.connectivity);
+        bisect(*sub_graph, sub_cell_ids[part], sub_first_block, sub_part_num[part]);
+        delete sub_graph;
+    }
+}
+
+void KWayPartitioner::evaluate() {
+    block_size_.assign(part_num_, 0);
+    for (int cell_id = 0; cell_id < graph_.getCellNum(); ++cell_id) { block_size_[block_[cell_id]] += graph_.getCellWeight(cell_id); }
+    // Count the blocks of each net, last_net marks the blocks already seen by the net
+    cut_size_     = 0;
+    connectivity_ = 0;
+    vector<int> last_net(part_num_, -1);
+    for (int net_id = 0; net_id < graph_.getNetNum(); ++net_id) {
+        int block_num = 0;
+        for (int cell_id : graph_.getCellList(net_id)) {
+            int block = block_[cell_id];
+            if (last_net[block] == net_id) continue;
+            last_net[block] = net_id;
+            ++block_num;
+        }
+        // A pinless net spans no block, so it counts for neither objective
+        if (block_num <= 1) continue;
+        int net_weight = graph_.getNetWeight(net_id);
+        cut_size_ += net_weight;
+        connectivity_ += long(net_weight) * (block_num - 1);
+    }
+}
+
+bool KWayPartitioner::isBalanced() const {
+    double lower_bound = (1 - graph_.getBFactor()) * graph_.getTotalWeight() / part_num_;
+    for (int block = 0; block < part_num_; ++block) {
+        if (block_size_[block] < lower_bound) return false;
+    }
+    return true;
+}
+
+void KWayPartitioner::printSummary() const {
+    cout << "\n";
+    cout << "==================== Summary ====================" << "\n";
+    cout << " Cutsize: " << cut_size_ << "\n";
+    cout << " Connectivity (lambda - 1): " << connectivity_ << "\n";
+    cout << " Total cell number: " << graph_.getCellNum() << "\n";
+    cout << " Total net number:  " << graph_.getAllNetNum() << "\n";
+    if (deadline_) cout << " Time limit: " << (deadline_->isCutOff() ? "cut off" : "converged") << "\n";
+    for (int block = 0; block < part_num_; ++block) { cout << " Cell Number of block G" << block + 1 << ": " << block_size_[block] << "\n"; }
+    if (!isBalanced()) cout << " Balance: violated, no balanced split was found for these cell weights\n";
+    cout << "=================================================" << "\n";
+    cout << "\n";
+    return;
+}
+
+void KWayPartitioner::writeResult(ResultWriter& writer) {
+    // Group the cells by block, each group stays in increasing id order
+    vector<int> offset(part_num_ + 1, 0);
+    for (int block : block_) { ++offset[block + 1]; }
+    partial_sum(offset.begin(), offset.end(), offset.begin());
+    vector<int> order(graph_.getCellNum());
+    vector<int> fill_pos(offset.begin(), offset.end() - 1);
+    for (int cell_id = 0; cell_id < graph_.getCellNum(); ++cell_id) { order[fill_pos[block_[cell_id]]++] = cell_id; }
+
+    writer.append("Cutsize = ");
+    writer.appendNumber(cut_size_);
+    writer.append('\n');
+    for (int block = 0; block < part_num_; ++block) {
+        writer.append('G');
+        writer.appendNumber(block + 1);
+        writer.append(' ');
+        writer.appendNumber(block_size_[block]);
+        writer.append('\n');
+        for (int i = offset[block]; i < offset[block + 1]; ++i) {
+            writer.append(graph_.getCellName(order[i]));
+            writer.append(' ');
+        }
+        writer.append(";\n");
+    }
+    writer.flush();
+    return;
+}
+
+void KWayPartitioner::writePartFile(ResultWriter& writer) {
+    // hMETIS partition file: the 0-based block of each vertex, one line per vertex in input order
+    vector<int> vertex_block(graph_.getCellNum());
+    for (int cell_id = 0; cell_id < graph_.getCellNum(); ++cell_id) { vertex_block[graph_.getHgrVertex(cell_id)] = block_[cell_id]; }
+    for (int block : vertex_block) {
+        writer.appendNumber(block);
+        writer.append('\n');
+    }
+    writer.flush();
+    return;
+}
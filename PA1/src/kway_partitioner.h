@@ -0,0 +1,55 @@
+#ifndef KWAY_PARTITIONER_H
+#define KWAY_PARTITIONER_H
+
+#include <vector>
+
+#include "config.h"
+#include "deadline.h"
+#include "hypergraph.h"
+#include "result_writer.h"
+using namespace std;
+
+// Recursive bisection into part_num blocks, each bisection runs the FM partitioner on an
+// in-memory sub-hypergraph of the cells it splits
+class KWayPartitioner {
+  public:
+    // constructor and destructor
+    // config holds the options of every bisection, deadline is the time limit of the call, nullptr if none
+    KWayPartitioner(const Hypergraph& graph, int part_num, Config config = Config(), Deadline* deadline = nullptr)
+        : graph_(graph), part_num_(part_num), config_(config), deadline_(deadline), b_factor_(0), cut_size_(0), connectivity_(0) {}
+    ~KWayPartitioner() {}
+
+    // modify method
+    void run();
+
+    // basic access methods
+    int getCutSize() const { return cut_size_; }
+    long getConnectivity() const { return connectivity_; }
+    // Whether every block keeps (1 - b) of its W / k share
+    bool isBalanced() const;
+
+    // member functions about reporting
+    void printSummary() const;
+    void writeResult(ResultWriter& writer);
+    void writePartFile(ResultWriter& writer);
+
+  private:
+    // Input data
+    const Hypergraph& graph_;  // the parsed hypergraph
+    int part_num_;             // number of blocks
+    Config config_;            // options of the call
+    Deadline* deadline_;       // time limit shared by all the bisections, nullptr if none
+    double b_factor_;          // balance factor of each bisection
+
+    // Partition solution
+    vector<int> block_;       // block each cell belongs to
+    vector<int> block_size_;  // size (cell weight) of each block
+    int cut_size_;            // weight of the nets spanning more than one block
+    long connectivity_;       // sum of weight * (blocks spanned - 1) over all nets
+
+    // Partitioner methods
+    void bisect(const Hypergraph& graph, const vector<int>& cell_ids, int first_block, int part_num);
+    void evaluate();
+};
+
+#endif  // KWAY_PARTITIONER_H
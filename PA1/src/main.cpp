@@ -1,38 +1,170 @@
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <vector>
 
+#include "config.h"
+#include "deadline.h"
+#include "hypergraph.h"
+#include "kway_partitioner.h"
+#include "mapped_file.h"
 #include "partitioner.h"
+#include "result_writer.h"
 using namespace std;
 int main(int argc, char** argv) {
     cin.tie(0);
     ios::sync_with_stdio(false);
     
-    fstream input, output;
+    MappedFile input;
+    fstream output;
+    fstream telemetry;
+    vector<char*> files;
+    Config config;               // options of the run, filled from the command line
+    char* cache_file = nullptr;  // where to write the binary cache of the parsed input
+    bool load_cache  = false;    // whether the input file is a binary cache
+    char* init_file  = nullptr;  // earlier result to start from
+    bool fix_known   = false;    // whether the known cells away from the edits are fixed
+    bool reorder     = false;    // whether the cells and nets are renumbered for locality
+    double b_factor  = -1;       // balance factor overriding the one of the input, -1 if not given
 
-    if (argc == 3) {
-        input.open(argv[1], ios::in);
-        output.open(argv[2], ios::out);
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--multilevel") == 0)
+            config.multilevel = true;
+        else if (strcmp(argv[i], "--level-passes") == 0 && i + 1 < argc)
+            config.level_pass_num = max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--starts") == 0 && i + 1 < argc)
+            config.start_num = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            config.thread_num = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--refiner") == 0 && i + 1 < argc)
+            config.jet = strcmp(argv[++i], "jet") == 0;
+        else if (strcmp(argv[i], "--initial") == 0 && i + 1 < argc)
+            config.stream_init = strcmp(argv[++i], "ldg") == 0;
+        else if (strcmp(argv[i], "--lookahead") == 0 && i + 1 < argc)
+            config.lookahead = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--pass-threads") == 0 && i + 1 < argc)
+            config.pass_thread_num = max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--early-moves") == 0 && i + 1 < argc)
+            config.early_move_num = max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--early-drop") == 0 && i + 1 < argc)
+            config.early_gain_drop = max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--parts") == 0 && i + 1 < argc)
+            config.part_num = max(2, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--objective") == 0 && i + 1 < argc)
+            config.connectivity = strcmp(argv[++i], "km1") == 0;
+        else if (strcmp(argv[i], "--balance") == 0 && i + 1 < argc)
+            b_factor = atof(argv[++i]);
+        else if (strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc)
+            config.time_limit = max(0.0, atof(argv[++i]));
+        else if (strcmp(argv[i], "--init") == 0 && i + 1 < argc)
+            init_file = argv[++i];
+        else if (strcmp(argv[i], "--fix-known") == 0)
+            fix_known = true;
+        else if (strcmp(argv[i], "--async-write") == 0)
+            config.async_write = true;
+        else if (strcmp(argv[i], "--emit-cache") == 0 && i + 1 < argc)
+            cache_file = argv[++i];
+        else if (strcmp(argv[i], "--load-cache") == 0)
+            load_cache = true;
+        else if (strcmp(argv[i], "--reorder") == 0)
+            reorder = true;
+        else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+            telemetry.open(argv[++i], ios::out);
+            if (!telemetry) {
+                cerr << "Cannot open the telemetry file \"" << argv[i] << "\". The program will be terminated..." << endl;
+                exit(1);
+            }
+            Partitioner::setTelemetry(&telemetry);
+        }
+        else
+            files.push_back(argv[i]);
+    }
+    if (init_file && config.part_num > 2) {
+        cerr << "--init only supports 2-way partitions. The program will be terminated..." << endl;
+        exit(1);
+    }
+    // The budget also covers parsing, so it starts right away
+    Deadline* deadline = config.time_limit > 0 ? new Deadline(config.time_limit) : nullptr;
+    if (files.size() == 2) {
+        input.open(files[0]);
+        output.open(files[1], ios::out);
         if (!input) {
-            cerr << "Cannot open the input file \"" << argv[1] << "\". The program will be terminated..." << endl;
+            cerr << "Cannot open the input file \"" << files[0] << "\". The program will be terminated..." << endl;
             exit(1);
         }
         if (!output) {
-            cerr << "Cannot open the output file \"" << argv[2] << "\". The program will be terminated..." << endl;
+            cerr << "Cannot open the output file \"" << files[1] << "\". The program will be terminated..." << endl;
             exit(1);
         }
     } else {
-        cerr << "Usage: ./fm <input file> <output file>" << endl;
+        cerr << "Usage: ./fm [--multilevel] [--level-passes N] [--starts N] [--threads T] [--pass-threads P] [--early-moves K] [--early-drop D]"
+                " [--parts K] [--initial index|ldg] [--refiner fm|jet] [--lookahead L] [--objective cut|km1] [--balance B] [--telemetry F]"
+                " [--emit-cache F] [--load-cache] [--reorder] [--async-write] [--time-limit S] [--init F] [--fix-known] <input file> <output file>"
+             << endl;
         exit(1);
     }
 
-    Partitioner* partitioner = new Partitioner(input);
-    partitioner->partition();
-    partitioner->printSummary();
-    partitioner->writeResult(output);
-    
-    delete partitioner;
+    // An input named *.hgr is read as an hMETIS hypergraph, and its result is written as a partition file
+    size_t name_size = strlen(files[0]);
+    bool hgr         = !load_cache && name_size >= 4 && strcmp(files[0] + name_size - 4, ".hgr") == 0;
+    Hypergraph* graph = load_cache ? Hypergraph::loadCache(input) : hgr ? Hypergraph::loadHgr(input, config.hgr_b_factor) : new Hypergraph(input);
+    if (!graph) {
+        cerr << "The input file \"" << files[0] << "\" is not a valid " << (hgr ? "hMETIS file within the net weight limits" : "cache")
+             << ". The program will be terminated..." << endl;
+        exit(1);
+    }
+    if (b_factor >= 0) graph->setBFactor(b_factor);
+    if (init_file && graph->isHgr()) {
+        cerr << "--init only reads results of NET format inputs. The program will be terminated..." << endl;
+        exit(1);
+    }
+    if (reorder) graph->reorder();
+    if (cache_file && !graph->writeCache(cache_file)) {
+        cerr << "Cannot write the cache file \"" << cache_file << "\". The program will be terminated..." << endl;
+        exit(1);
+    }
+    // The hypergraph keeps its own copy of the names, so the input mapping is released before partitioning
     input.close();
+    // The last bulk write of the result overlaps with the teardown when async
+    ResultWriter writer(output, config.async_write);
+    if (config.part_num > 2) {
+        KWayPartitioner* partitioner = new KWayPartitioner(*graph, config.part_num, config, deadline);
+        partitioner->run();
+        partitioner->printSummary();
+        if (graph->isHgr())
+            partitioner->writePartFile(writer);
+        else
+            partitioner->writeResult(writer);
+        delete partitioner;
+    } else if (init_file) {
+        // Incremental run: one flat FM from the earlier result
+        MappedFile init_input;
+        vector<int> cell_part;
+        if (!init_input.open(init_file) || !graph->parseResult(init_input, cell_part)) {
+            cerr << "Cannot read the 2-way result \"" << init_file << "\". The program will be terminated..." << endl;
+            exit(1);
+        }
+        Partitioner* partitioner = new Partitioner(*graph, graph->getBFactor(), 0.5, config, 0, deadline);
+        partitioner->seedPartition(cell_part, fix_known);
+        partitioner->partition();
+        partitioner->printSummary();
+        partitioner->writeResult(writer);
+        delete partitioner;
+    } else {
+        Partitioner* partitioner = Partitioner::multiStartPartition(*graph, graph->getBFactor(), 0.5, config, deadline);
+        partitioner->printSummary();
+        if (graph->isHgr())
+            partitioner->writePartFile(writer);
+        else
+            partitioner->writeResult(writer);
+        delete partitioner;
+    }
+    delete graph;
+    delete deadline;
+    writer.close();
     output.close();
+    telemetry.close();
 
     return 0;
 }
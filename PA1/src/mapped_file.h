@@ -0,0 +1,32 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+using namespace std;
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+  public:
+    // constructor and destructor
+    MappedFile() : data_(nullptr), size_(0), is_open_(false) {}
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    // modify methods
+    bool open(const char* file_name);
+    void close();
+
+    // basic access methods
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+    explicit operator bool() const { return is_open_; }
+
+  private:
+    const char* data_;  // start of the mapped file
+    size_t size_;       // size of the mapped file in bytes
+    bool is_open_;      // whether the file is opened
+};
+
+#endif  // MAPPED_FILE_H
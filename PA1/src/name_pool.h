@@ -0,0 +1,51 @@
+#ifndef NAME_POOL_H
+#define NAME_POOL_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+using namespace std;
+
+// Names stored back to back in one buffer, name i is the bytes between offsets i and i + 1.
+// A name costs its bytes and a 4-byte offset, the views handed out are valid until the next push_back.
+class NamePool {
+  public:
+    // constructor and destructor
+    NamePool() : offset_(1, 0) {}
+    ~NamePool() {}
+
+    // modify methods
+    void push_back(string_view name) {
+        bytes_.append(name);
+        offset_.push_back(bytes_.size());
+    }
+    void reserve(int num, size_t byte_num) {
+        offset_.reserve(num + 1);
+        bytes_.reserve(byte_num);
+    }
+    void clear() {
+        offset_.assign(1, 0);
+        bytes_.clear();
+    }
+    void swap(NamePool& other) {
+        offset_.swap(other.offset_);
+        bytes_.swap(other.bytes_);
+    }
+    // Release the spare capacity left by growing the pool one name at a time
+    void shrink() {
+        offset_.shrink_to_fit();
+        bytes_.shrink_to_fit();
+    }
+
+    // basic access methods
+    string_view operator[](int id) const { return string_view(bytes_.data() + offset_[id], offset_[id + 1] - offset_[id]); }
+    int size() const { return offset_.size() - 1; }
+    size_t byteSize() const { return bytes_.size(); }
+
+  private:
+    vector<uint32_t> offset_;  // start of each name in bytes_, size() + 1 entries
+    string bytes_;             // all names back to back
+};
+
+#endif  // NAME_POOL_H
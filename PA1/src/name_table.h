@@ -0,0 +1,73 @@
+#ifndef NAME_TABLE_H
+#define NAME_TABLE_H
+
+#include <string_view>
+#include <vector>
+
+#include "name_pool.h"
+using namespace std;
+
+// Open-addressing hash table from a name to its index in an external name pool,
+// the table itself only keeps the ids
+class NameTable {
+  public:
+    // constructor and destructor
+    NameTable() : size_(0), slot_(16, -1) {}
+    ~NameTable() {}
+
+    // Return the id of the name, appending it to names with a new id if it is not seen yet
+    int intern(string_view name, NamePool& names) {
+        if (2 * size_t(size_ + 1) > slot_.size()) rehash(names);
+        size_t mask = slot_.size() - 1;
+        for (size_t i = hash(name) & mask;; i = (i + 1) & mask) {
+            if (slot_[i] == -1) {
+                slot_[i] = names.size();
+                names.push_back(name);
+                ++size_;
+                return slot_[i];
+            }
+            if (names[slot_[i]] == name) return slot_[i];
+        }
+    }
+
+    // Return the id of the name, -1 if it is not in the table
+    int find(string_view name, const NamePool& names) const {
+        size_t mask = slot_.size() - 1;
+        for (size_t i = hash(name) & mask;; i = (i + 1) & mask) {
+            if (slot_[i] == -1 || names[slot_[i]] == name) return slot_[i];
+        }
+    }
+
+    // Fill the table with names whose ids are their indices, for names not added through intern
+    void assign(const NamePool& names) {
+        size_ = names.size();
+        size_t slot_num = 16;
+        while (slot_num < 2 * size_t(size_ + 1)) { slot_num *= 2; }
+        slot_.assign(slot_num / 2, -1);
+        rehash(names);
+    }
+
+    int size() const { return size_; }
+
+  private:
+    // FNV-1a hash of the name
+    static size_t hash(string_view name) {
+        size_t h = 14695981039346656037ULL;
+        for (char c : name) { h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ULL; }
+        return h;
+    }
+    void rehash(const NamePool& names) {
+        slot_.assign(2 * slot_.size(), -1);
+        size_t mask = slot_.size() - 1;
+        for (int id = 0; id < size_; ++id) {
+            size_t i = hash(names[id]) & mask;
+            while (slot_[i] != -1) { i = (i + 1) & mask; }
+            slot_[i] = id;
+        }
+    }
+
+    int size_;          // number of names in the table
+    vector<int> slot_;  // id of the name in each slot, -1 for an empty slot
+};
+
+#endif  // NAME_TABLE_H
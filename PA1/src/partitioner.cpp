@@ -1,190 +1,527 @@
 #include "partitioner.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
-#include <iomanip>
 #include <iostream>
-#include <queue>
+#include <mutex>
+#include <numeric>
 #include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
 
-#include "cell.h"
-#include "net.h"
 using namespace std;
 
-constexpr double init_factor  = 0.9;
-constexpr double early_factor = 1.5;
-
-void Partitioner::parseInput(fstream& in_file) {
-    string str;
-    // Set balance factor
-    in_file >> str;
-    b_factor_ = stod(str);
-
-    // Set up whole circuit
-    while (in_file >> str) {
-        if (str == "NET") {
-            string net_name, cell_name, tmp_cell_name = "";
-            in_file >> net_name;
-            Net* net = new Net(net_name);
-            while (in_file >> cell_name) {
-                if (cell_name == ";") {
-                    tmp_cell_name = "";
-                    break;
-                } else {
-                    int cell_id;
-                    // a newly seen cell not in cell_array_
-                    if (!cell_name_2_id_.count(cell_name)) {
-                        cell_id = cell_num_;
-                        cell_array_.push_back(new Cell(cell_name, 0, cell_id));
-                        cell_name_2_id_[cell_name] = cell_id;
-                        ++cell_num_;
-                    }
-                    // an seen cell in cell_array_, but already added to the net
-                    else if (tmp_cell_name == cell_name) {
-                        continue;
-                        // an seen cell in cell_array_
-                    } else {
-                        cell_id = cell_name_2_id_[cell_name];
-                    }
-                    cell_array_[cell_id]->addNet(net_num_);
-                    net->addCell(cell_id);
-                    tmp_cell_name = cell_name;
-                }
-            }
-            // Delete the net if it is a single-pin net
-            if (net->getCellList().size() == 1) {
-                cell_array_[net->getCellList()[0]]->cancelNet();
-                delete net;
-            } else {
-                net_array_.push_back(net);
-                ++net_num_;
-            }
-            ++all_net_num_;
-        }
+constexpr double init_factor    = 0.9;
+constexpr int min_slice_size    = 1 << 14;  // fewest cells or moves worth a thread of their own in a pass
+constexpr double jet_filter     = 0.25;     // Jet: a cell losing less than this share of its net weight is still a candidate
+constexpr int jet_stall_num     = 12;       // Jet: rounds without a 0.1% better cut before refinement stops
+constexpr double level_min_gain = 0.001;    // V-cycle: a projected level stops after a pass gaining less than this share of the cut
+constexpr int lookahead_window  = 16;       // lookahead: cells at the front of the max gain bucket compared by their lookahead gains
+
+// Slice count for num items of pass work, at most thread_num
+static int getSliceNum(int num, int thread_num) { return max(1, min(thread_num, num / min_slice_size)); }
+
+// Run body(slice, begin, end) on slice_num contiguous slices of [0, num), one thread each,
+// the calling thread takes slice 0
+template <class Body>
+static void parallelFor(int num, int slice_num, const Body& body) {
+    vector<thread> threads;
+    for (int slice = 1; slice < slice_num; ++slice) {
+        threads.emplace_back(body, slice, int(long(num) * slice / slice_num), int(long(num) * (slice + 1) / slice_num));
     }
+    body(0, 0, int(long(num) / slice_num));
+    for (thread& t : threads) { t.join(); }
 }
 
+ostream* Partitioner::telemetry_ = nullptr;
+mutex Partitioner::telemetry_mutex_;
+
 void Partitioner::initPartition() {
-    int max_pin_num = 0;
-    int limit      = ceil((1 - init_factor * b_factor_) * cell_num_ / 2.0);
-    for (int cell_id = 0; cell_id < cell_num_; ++cell_id) {
-        Cell* cell  = cell_array_[cell_id];
-        max_pin_num = max(max_pin_num, cell->getPinNum());
-        // Set initial partition rule
-        bool part = cell_id < limit;
-        cell->setPart(part);
-        ++part_size_[part];
-        for (int net_id : cell->getNetList()) { net_array_[net_id]->incPartCount(part); }
+    int cell_num = graph_.getCellNum();
+    gain_.assign(cell_num, 0);
+    init_gain_.assign(cell_num, 0);
+    part_.assign(cell_num, 0);
+    lock_.assign(cell_num, 0);
+    fixed_.assign(cell_num, 0);
+    part_count_.assign(2 * graph_.getNetNum(), 0);
+    change_move_.assign(cell_num, 0);
+    lookahead_num_ = max(0, min(2, config_.lookahead - 1));
+    lookahead_gain_.assign(size_t(cell_num) * lookahead_num_, 0);
+
+    // A streamed seed the weights keep from being balanced falls back to the index split
+    if (config_.stream_init) streamPartition();
+    if (!config_.stream_init || !isBalanced()) {
+        // Start 0 splits by index, the other starts split a random permutation
+        vector<int> order(cell_num);
+        iota(order.begin(), order.end(), 0);
+        if (start_ != 0) shuffle(order.begin(), order.end(), rng_);
+        int limit      = ceil((1 - init_factor * b_factor_) * graph_.getTotalWeight() * (1 - ratio_));
+        int acc_weight = 0;
+        part_size_[0]  = part_size_[1] = 0;
+        for (int cell_id : order) {
+            // Set initial partition rule
+            bool part      = acc_weight < limit;
+            part_[cell_id] = part;
+            acc_weight += graph_.getCellWeight(cell_id);
+            part_size_[part] += graph_.getCellWeight(cell_id);
+        }
+        // Only part B(1) is filled up to its share, weighted cells can leave part A(0) below its lower bound
+        balanceParts();
+    }
+    initPartCount();
+
+    // Initialize bucket list
+    int max_degree = graph_.getMaxDegree();
+    blist_size_    = 4 * max_degree + 1;
+    blist_offset_  = -2 * max_degree;
+    prev_.resize(cell_num + 2 * blist_size_);
+    next_.resize(cell_num + 2 * blist_size_);
+    int word_num = (blist_size_ + 63) / 64;
+    for (int part = 0; part < 2; ++part) {
+        blist_bit_[part].resize(word_num);
+        blist_word_bit_[part].resize((word_num + 63) / 64);
+    }
+
+    move_stack_.reserve(cell_num);
+    clip_order_.resize(cell_num);
+}
+
+void Partitioner::initPartCount() {
+    part_size_[0] = part_size_[1] = 0;
+    fill(part_count_.begin(), part_count_.end(), 0);
+    // The partition is set from scratch, so no gain can be carried over
+    fill(change_move_.begin(), change_move_.end(), 0);
+    for (int cell_id = 0; cell_id < graph_.getCellNum(); ++cell_id) {
+        bool part = part_[cell_id];
+        part_size_[part] += graph_.getCellWeight(cell_id);
+        for (int net_id : graph_.getNetList(cell_id)) { ++partCount(net_id, part); }
     }
     // Calculate initial cutsize
-    for (Net* net : net_array_) {
-        if (net->getPartCount(0) != 0 && net->getPartCount(1) != 0) ++cut_size_;
+    cut_size_ = 0;
+    for (int net_id = 0; net_id < graph_.getNetNum(); ++net_id) {
+        if (partCount(net_id, 0) != 0 && partCount(net_id, 1) != 0) cut_size_ += graph_.getNetWeight(net_id);
     }
+}
 
-    // Initialize bucket list
-    int bucket_size = 4 * max_pin_num + 1;
-    blist_[0].assign(bucket_size, nullptr);
-    blist_[1].assign(bucket_size, nullptr);
-    blist_offset_ = -2 * max_pin_num;
+void Partitioner::run() {
+    if (config_.multilevel)
+        multilevelPartition();
+    else
+        refine();
+}
 
-    move_stack_.reserve(cell_num_);
+void Partitioner::refine(int max_pass_num, double min_gain_ratio) {
+    if (config_.jet)
+        jetRefine();
+    else
+        partition(max_pass_num, min_gain_ratio);
 }
 
-void Partitioner::partition() {
-    int lower_bound = ceil((1 - b_factor_) * cell_num_ / 2.0);
-    while(1) {
+void Partitioner::partition(int max_pass_num, double min_gain_ratio) {
+    int lower_bound[2] = {getLowerBound(0), getLowerBound(1)};
+    for (int pass = 0; max_pass_num == 0 || pass < max_pass_num; ++pass) {
+        if (isTimeOut()) break;
+        auto pass_begin = chrono::steady_clock::now();
+        int init_cut    = cut_size_;
         initPass();
         bool last_from = 0;
         while (1) {
             // Choose the cell to move
             int move_cell_id;
+            int top_cell[2];
             bool can_move[2];
-            can_move[0] = max_clip_gain_cell_[0] && part_size_[0] > lower_bound;
-            can_move[1] = max_clip_gain_cell_[1] && part_size_[1] > lower_bound;
+            for (int part = 0; part < 2; ++part) {
+                top_cell[part] = max_blist_id_[part] != -1 ? getMoveCell(part) : -1;
+                can_move[part] = top_cell[part] != -1 && part_size_[part] - graph_.getCellWeight(top_cell[part]) >= lower_bound[part];
+            }
             if (!can_move[0] && !can_move[1])
                 break;
             else if (!can_move[0] && can_move[1])
-                move_cell_id = max_clip_gain_cell_[1]->getId();
+                move_cell_id = top_cell[1];
             else if (can_move[0] && !can_move[1])
-                move_cell_id = max_clip_gain_cell_[0]->getId();
+                move_cell_id = top_cell[0];
             else {
-                int max_clip_gain0 = cell_array_[max_clip_gain_cell_[0]->getId()]->getCLIPGain(),
-                    max_clip_gain1 = cell_array_[max_clip_gain_cell_[1]->getId()]->getCLIPGain();
-                if (max_clip_gain0 == max_clip_gain1)
-                    move_cell_id = max_clip_gain_cell_[last_from]->getId();
+                if (max_blist_id_[0] == max_blist_id_[1])
+                    move_cell_id = top_cell[last_from];
                 else
-                    move_cell_id = max_clip_gain0 > max_clip_gain1 ? max_clip_gain_cell_[0]->getId() : max_clip_gain_cell_[1]->getId();
+                    move_cell_id = top_cell[max_blist_id_[0] < max_blist_id_[1]];
             }
 
             // Move the cell
-            bool from = cell_array_[move_cell_id]->getPart();
+            bool from = part_[move_cell_id];
             moveCell(move_cell_id);
             updateGain(move_cell_id, from, !from);
             last_from = from;
+
+            // Early exit: the rest of the pass is unlikely to beat max_acc_gain_
+            if ((config_.early_move_num && move_num_ - best_move_num_ >= config_.early_move_num) ||
+                (config_.early_gain_drop && max_acc_gain_ - acc_gain_ >= config_.early_gain_drop)) {
+                early_skip_num_ += graph_.getCellNum() - move_num_;
+                break;
+            }
+            // The clock is read every 256 moves, once the time is up the pass stops at its best prefix
+            if ((move_num_ & 255) == 0 && isTimeOut()) break;
         }
+        ++pass_num_;
+        if (telemetry_)
+            reportPass(init_cut, max_acc_gain_, best_move_num_, move_num_, scan_num_,
+                       chrono::duration<double, milli>(chrono::steady_clock::now() - pass_begin).count());
         if (max_acc_gain_ <= 0) {
+            // No improvement: the end of the pass is kept only if it is as good as its start,
+            // which an early exit cannot guarantee
+            if (acc_gain_ == 0) break;
+            max_acc_gain_  = 0;
+            best_move_num_ = 0;
+        }
+        // Back to the best solution
+        cut_size_ -= max_acc_gain_;
+        auto undo_begin = move_stack_.begin() + best_move_num_;
+        for (auto it = undo_begin; it != move_stack_.end(); ++it) {
+            part_[*it]     = !part_[*it];
+            bool real_part = part_[*it];
+            part_size_[real_part] += graph_.getCellWeight(*it);
+            part_size_[!real_part] -= graph_.getCellWeight(*it);
+        }
+        // Each slice of the undone moves has its part counts updated by one thread; the increments and
+        // decrements commute, so with relaxed atomics the counts do not depend on the order
+        int undo_num  = move_stack_.end() - undo_begin;
+        int slice_num = getSliceNum(undo_num, config_.pass_thread_num);
+        parallelFor(undo_num, slice_num, [&](int, int begin, int end) {
+            for (auto it = undo_begin + begin; it != undo_begin + end; ++it) {
+                for (int net_id : graph_.getNetList(*it)) {
+                    if (slice_num == 1)
+                        moveNetCell(net_id, part_[*it]);
+                    else
+                        moveNetCellAtomic(net_id, part_[*it]);
+                }
+            }
+        });
+        if (max_acc_gain_ == 0 || max_acc_gain_ < min_gain_ratio * init_cut) break;
+    }
+}
+
+void Partitioner::multilevelPartition() {
+    // The coarse levels know nothing of fixed cells and the projection would move them, so a
+    // partitioner with fixed cells refines flat
+    if (any_of(fixed_.begin(), fixed_.end(), [](char fixed) { return fixed; })) {
+        refine();
+        return;
+    }
+    // Coarsening phase
+    vector<const Hypergraph*> graphs{&graph_};
+    vector<Partitioner*> levels{this};
+    vector<vector<int>> cluster_ids;
+    while (graphs.back()->getCellNum() > config_.coarsest_cell_num && !isTimeOut()) {
+        const Hypergraph* fine = graphs.back();
+        vector<int> cluster_id;
+        Hypergraph* coarse = fine->coarsen(cluster_id, rng_, config_.max_match_net_size);
+        if (coarse->getCellNum() > config_.coarsen_ratio * fine->getCellNum()) {
+            delete coarse;
             break;
-        } else {
-            // Back to the best solution
-            cut_size_ -= max_acc_gain_;
-            for (auto it = move_stack_.begin() + best_move_num_; it != move_stack_.end(); ++it) {
-                Cell* cell = cell_array_[*it];
-                cell->move();
-                bool real_part = cell->getPart();
-                ++part_size_[real_part];
-                --part_size_[!real_part];
-                for (int net_id : cell->getNetList()) { net_array_[net_id]->moveNetCell(real_part); }
+        }
+        graphs.push_back(coarse);
+        levels.push_back(new Partitioner(*coarse, b_factor_, ratio_, config_, start_, deadline_));
+        cluster_ids.push_back(move(cluster_id));
+    }
+
+    // Initial partitioning on the coarsest level
+    levels.back()->partition();
+
+    // Uncoarsening phase: project and refine level by level
+    for (int level = levels.size() - 1; level > 0; --level) {
+        levels[level - 1]->project(*levels[level], cluster_ids[level - 1]);
+        // The projected solution is already good: its first passes take most of the gain left, the
+        // long tail of small passes would cost as much as a flat run
+        levels[level - 1]->refine(config_.level_pass_num, level_min_gain);
+        delete levels[level];
+        delete graphs[level];
+    }
+}
+
+void Partitioner::seedPartition(const vector<int>& cell_part, bool fix_known) {
+    // Known cells keep their part, counted first so the new cells can follow their nets
+    vector<int> new_cells;
+    fill(part_count_.begin(), part_count_.end(), 0);
+    part_size_[0] = part_size_[1] = 0;
+    for (int cell_id = 0; cell_id < graph_.getCellNum(); ++cell_id) {
+        if (cell_part[cell_id] == -1) {
+            new_cells.push_back(cell_id);
+            continue;
+        }
+        bool part      = cell_part[cell_id];
+        part_[cell_id] = part;
+        part_size_[part] += graph_.getCellWeight(cell_id);
+        for (int net_id : graph_.getNetList(cell_id)) { ++partCount(net_id, part); }
+    }
+
+    // Each new cell joins the part with more of its nets already placed, unless that part would
+    // leave the other one below its lower bound
+    int total_weight = graph_.getTotalWeight();
+    for (int cell_id : new_cells) {
+        int net_num[2] = {0, 0};
+        for (int net_id : graph_.getNetList(cell_id)) {
+            net_num[0] += (partCount(net_id, 0) != 0) * graph_.getNetWeight(net_id);
+            net_num[1] += (partCount(net_id, 1) != 0) * graph_.getNetWeight(net_id);
+        }
+        bool part = net_num[1] > net_num[0] || (net_num[1] == net_num[0] && part_size_[1] < part_size_[0]);
+        if (part_size_[part] + graph_.getCellWeight(cell_id) > total_weight - getLowerBound(!part)) part = !part;
+        part_[cell_id] = part;
+        part_size_[part] += graph_.getCellWeight(cell_id);
+        for (int net_id : graph_.getNetList(cell_id)) { ++partCount(net_id, part); }
+    }
+
+    // Removed cells can still leave a part too light
+    balanceParts();
+    initPartCount();
+
+    // Fix the known cells away from the edits and from the cut, FM then only refines the cells
+    // sharing a net with a new cell or a cut net
+    if (fix_known) {
+        vector<char> free_net(graph_.getNetNum(), 0);
+        for (int net_id = 0; net_id < graph_.getNetNum(); ++net_id) { free_net[net_id] = partCount(net_id, 0) != 0 && partCount(net_id, 1) != 0; }
+        for (int cell_id : new_cells) {
+            for (int net_id : graph_.getNetList(cell_id)) { free_net[net_id] = true; }
+        }
+        for (int cell_id = 0; cell_id < graph_.getCellNum(); ++cell_id) {
+            if (cell_part[cell_id] == -1) continue;
+            fixed_[cell_id] = true;
+            for (int net_id : graph_.getNetList(cell_id)) {
+                if (free_net[net_id]) fixed_[cell_id] = false;
             }
         }
     }
 }
 
+Partitioner* Partitioner::multiStartPartition(const Hypergraph& graph, double b_factor, double ratio, Config config, Deadline* deadline) {
+    // Each worker takes the next start, runs it on its own Partitioner and keeps the lowest cut
+    Partitioner* best = nullptr;
+    atomic<int> next_start(0);
+    mutex best_mutex;
+    auto worker = [&]() {
+        // Once the time is up, only start 0 is still run to have a solution at all
+        for (int start = next_start++; start < config.start_num && (start == 0 || !deadline || !deadline->isTimeOut()); start = next_start++) {
+            Partitioner* partitioner = new Partitioner(graph, b_factor, ratio, config, start, deadline);
+            partitioner->run();
+            lock_guard<mutex> lock(best_mutex);
+            // Balanced results first, then the lowest cut, ties broken by the start index to keep the result deterministic
+            if (!best || make_tuple(!partitioner->isBalanced(), partitioner->cut_size_, start) <
+                             make_tuple(!best->isBalanced(), best->cut_size_, best->start_))
+                swap(best, partitioner);
+            delete partitioner;
+        }
+    };
+    vector<thread> threads;
+    for (int i = 1; i < config.thread_num; ++i) { threads.emplace_back(worker); }
+    worker();
+    for (thread& t : threads) { t.join(); }
+    return best;
+}
+
 void Partitioner::initPass() {
-    acc_gain_              = 0;
-    max_acc_gain_          = INT32_MIN;
-    move_num_              = 0;
-    best_move_num_         = 0;
-    max_clip_gain_cell_[0] = nullptr;
-    max_clip_gain_cell_[1] = nullptr;
+    int kept_move_num = best_move_num_;  // moves kept from the last pass
+    acc_gain_        = 0;
+    max_acc_gain_    = INT32_MIN;
+    move_num_        = 0;
+    best_move_num_   = 0;
+    scan_num_        = 0;
+    max_blist_id_[0] = -1;
+    max_blist_id_[1] = -1;
     move_stack_.clear();
-    for (auto& blist_part : blist_) { fill(blist_part.begin(), blist_part.end(), nullptr); }
-
-    auto comp_cell = [](Cell* a, Cell* b) { return a->getGain() < b->getGain(); };
-    priority_queue<Cell*, vector<Cell*>, decltype(comp_cell)> min_heap(comp_cell);
-
-    for (Cell* cell : cell_array_) {
-        Node* cell_node = cell->getNode();
-        cell->unlock();
-        int gain  = 0;
-        bool part = cell->getPart();
-        // Calculate initial gain
-        for (int net_id : cell->getNetList()) {
-            if (net_array_[net_id]->getPartCount(part) == 1)
-                ++gain;
-            else if (net_array_[net_id]->getPartCount(!part) == 0)
-                --gain;
-        }
-        min_heap.push(cell);
-        cell->setGain(gain);
-        cell->setInitGain();
+    for (int head = graph_.getCellNum(); head < int(next_.size()); ++head) { prev_[head] = next_[head] = head; }
+    for (int part = 0; part < 2; ++part) {
+        fill(blist_bit_[part].begin(), blist_bit_[part].end(), 0);
+        fill(blist_word_bit_[part].begin(), blist_word_bit_[part].end(), 0);
     }
+
     // CLIP: clear the gains to 0 while maintaining the orderings
-    // Start inserting to bucket[part][0] from the min gain cell
-    while (!min_heap.empty()) {
-        insertBucketList(min_heap.top(), 0);
-        min_heap.pop();
+    // Counting sort by decreasing gain, a gain lies in [-max_degree, max_degree] and goes to bin max_degree - gain.
+    // Each slice of cells counts its own bins, so the slices run in parallel and the order stays the serial one.
+    int max_degree = graph_.getMaxDegree();
+    int bin_num    = 2 * max_degree + 1;
+    int slice_num  = getSliceNum(graph_.getCellNum(), config_.pass_thread_num);
+    gain_count_.assign(size_t(slice_num) * bin_num, 0);
+    parallelFor(graph_.getCellNum(), slice_num, [&](int slice, int begin, int end) {
+        int* count = gain_count_.data() + size_t(slice) * bin_num;
+        for (int cell_id = begin; cell_id < end; ++cell_id) {
+            lock_[cell_id] = fixed_[cell_id];
+            int gain       = init_gain_[cell_id];
+            // Calculate initial gain
+            // The moves after kept_move_num are rolled back, so a cell whose gain only changed
+            // there still has the initial gain of the last pass
+            if (change_move_[cell_id] <= kept_move_num) gain = calcGain(cell_id);
+            change_move_[cell_id] = INT32_MAX;
+            gain_[cell_id] = init_gain_[cell_id] = gain;
+            // The lookahead gains also change with moves of cells two or more pins away, so they are always recalculated
+            if (lookahead_num_) calcLookahead(cell_id);
+            ++count[max_degree - gain];
+        }
+    });
+    // Turn the counts into start positions, bin by bin and slice by slice within a bin
+    int pos = 0;
+    for (int bin = 0; bin < bin_num; ++bin) {
+        for (int slice = 0; slice < slice_num; ++slice) {
+            int& count = gain_count_[size_t(slice) * bin_num + bin];
+            int num    = count;
+            count      = pos;
+            pos += num;
+        }
+    }
+    parallelFor(graph_.getCellNum(), slice_num, [&](int slice, int begin, int end) {
+        int* start = gain_count_.data() + size_t(slice) * bin_num;
+        for (int cell_id = begin; cell_id < end; ++cell_id) { clip_order_[start[max_degree - init_gain_[cell_id]]++] = cell_id; }
+    });
+    // Start inserting to bucket[part][0] from the max gain cell, so the min gain cell ends at the front
+    for (int cell_id : clip_order_) {
+        if (!fixed_[cell_id]) insertBucketList(cell_id, 0);
+    }
+}
+
+void Partitioner::fixCells(const vector<int>& cell_part) {
+    part_size_[0] = part_size_[1] = 0;
+    for (int cell_id = 0; cell_id < graph_.getCellNum(); ++cell_id) {
+        fixed_[cell_id] = cell_part[cell_id] != -1;
+        if (fixed_[cell_id]) part_[cell_id] = cell_part[cell_id];
+        part_size_[bool(part_[cell_id])] += graph_.getCellWeight(cell_id);
+    }
+    // The fixed cells can leave a part too light
+    balanceParts();
+    initPartCount();
+}
+
+void Partitioner::streamPartition() {
+    // Linear deterministic greedy (LDG) in one pass over the nets, in input order for start 0 and in
+    // a random order for the other starts: each cell is placed when its first net comes, in the part
+    // holding more weight of its nets already placed, scaled by the room the part has left
+    int cell_num = graph_.getCellNum();
+    int capacity[2];
+    for (int part = 0; part < 2; ++part) { capacity[part] = graph_.getTotalWeight() - getLowerBound(!part); }
+    part_size_[0] = part_size_[1] = 0;
+    vector<char> placed(cell_num, 0);
+    auto place = [&](int cell_id) {
+        double score[2] = {0, 0};
+        for (int net_id : graph_.getNetList(cell_id)) {
+            for (int part = 0; part < 2; ++part) { score[part] += (partCount(net_id, part) != 0) * graph_.getNetWeight(net_id); }
+        }
+        double room[2];
+        for (int part = 0; part < 2; ++part) { room[part] = 1 - double(part_size_[part]) / capacity[part]; }
+        // On a tie, the part with more room left takes the cell
+        bool part = score[1] * room[1] > score[0] * room[0] || (score[1] * room[1] == score[0] * room[0] && room[1] > room[0]);
+        if (part_size_[part] + graph_.getCellWeight(cell_id) > capacity[part]) part = !part;
+        part_[cell_id]  = part;
+        placed[cell_id] = true;
+        part_size_[part] += graph_.getCellWeight(cell_id);
+        for (int net_id : graph_.getNetList(cell_id)) { ++partCount(net_id, part); }
+    };
+    auto placeNet = [&](int net_id) {
+        for (int cell_id : graph_.getCellList(net_id)) {
+            if (!placed[cell_id]) place(cell_id);
+        }
+    };
+    if (start_ == 0) {
+        for (int net_id = 0; net_id < graph_.getNetNum(); ++net_id) { placeNet(net_id); }
+    } else {
+        vector<int> net_order(graph_.getNetNum());
+        iota(net_order.begin(), net_order.end(), 0);
+        shuffle(net_order.begin(), net_order.end(), rng_);
+        for (int net_id : net_order) { placeNet(net_id); }
+    }
+    // Cells on no net are never streamed
+    for (int cell_id = 0; cell_id < cell_num; ++cell_id) {
+        if (!placed[cell_id]) place(cell_id);
+    }
+    balanceParts();
+}
+
+void Partitioner::balanceParts() {
+    // Free cells move over to a part below its lower bound in index order, as long as the other part stays above its own
+    for (int part = 0; part < 2; ++part) {
+        for (int cell_id = 0; cell_id < graph_.getCellNum() && part_size_[part] < getLowerBound(part); ++cell_id) {
+            if (fixed_[cell_id] || part_[cell_id] == part || part_size_[!part] - graph_.getCellWeight(cell_id) < getLowerBound(!part)) continue;
+            part_[cell_id] = part;
+            part_size_[part] += graph_.getCellWeight(cell_id);
+            part_size_[!part] -= graph_.getCellWeight(cell_id);
+        }
+    }
+}
+
+int Partitioner::calcGain(int cell_id) {
+    bool part = part_[cell_id];
+    int gain  = 0;
+    for (int net_id : graph_.getNetList(cell_id)) {
+        if (partCount(net_id, part) == 1)
+            gain += graph_.getNetWeight(net_id);
+        else if (partCount(net_id, !part) == 0)
+            gain -= graph_.getNetWeight(net_id);
+    }
+    return gain;
+}
+
+void Partitioner::calcLookahead(int cell_id) {
+    // Level-k gain: the nets k moves of this part would uncut, minus the nets whose other part has
+    // k - 1 cells, which one more cell there keeps from being uncut as soon; locks are not considered
+    bool part      = part_[cell_id];
+    int* lookahead = lookahead_gain_.data() + size_t(cell_id) * lookahead_num_;
+    fill(lookahead, lookahead + lookahead_num_, 0);
+    for (int net_id : graph_.getNetList(cell_id)) {
+        int own   = partCount(net_id, part);
+        int other = partCount(net_id, !part);
+        for (int level = 0; level < lookahead_num_; ++level) {
+            lookahead[level] += graph_.getNetWeight(net_id) * ((own == level + 2) - (other == level + 1));
+        }
+    }
+}
+
+void Partitioner::updateLookahead(int net_id, bool from) {
+    // The counts go from f and t to f - 1 and t + 1, delta[side][level] is the change of the level
+    // gain of the cells left in from (side 0) and of the cells in to (side 1)
+    int f = partCount(net_id, from), t = partCount(net_id, !from);
+    int delta[2][2] = {};
+    bool changed    = false;
+    for (int level = 0; level < lookahead_num_; ++level) {
+        int k           = level + 2;
+        delta[0][level] = ((f - 1 == k) - (f == k)) - ((t + 1 == k - 1) - (t == k - 1));
+        delta[1][level] = ((t + 1 == k) - (t == k)) - ((f - 1 == k - 1) - (f == k - 1));
+        changed |= delta[0][level] || delta[1][level];
+    }
+    if (!changed) return;
+    int net_weight = graph_.getNetWeight(net_id);
+    for (int cell_id : graph_.getCellList(net_id)) {
+        if (lock_[cell_id]) continue;
+        int* lookahead = lookahead_gain_.data() + size_t(cell_id) * lookahead_num_;
+        bool side      = part_[cell_id] != from;
+        for (int level = 0; level < lookahead_num_; ++level) { lookahead[level] += net_weight * delta[side][level]; }
+    }
+}
+
+int Partitioner::getMoveCell(bool part) const {
+    int cell_id = getMaxCLIPGainCell(part);
+    if (!lookahead_num_) return cell_id;
+    // Among the first cells of the max gain bucket, the one with the highest lookahead gains in level
+    // order wins, the earlier one on ties
+    int head      = getHead(part, max_blist_id_[part]);
+    const int* la = lookahead_gain_.data();
+    int best      = cell_id;
+    for (int i = 1; i < lookahead_window && (cell_id = next_[cell_id]) != head; ++i) {
+        const int* a = la + size_t(cell_id) * lookahead_num_;
+        const int* b = la + size_t(best) * lookahead_num_;
+        if (lexicographical_compare(b, b + lookahead_num_, a, a + lookahead_num_)) best = cell_id;
     }
+    return best;
 }
 
 void Partitioner::moveCell(int move_cell_id) {
-    Cell* cell = cell_array_[move_cell_id];
-    int part   = cell->getPart();
-    --part_size_[part];
-    ++part_size_[!part];
-    removeBucketList(cell);
-    cell->move();
-    cell->lock();
-    acc_gain_ += cell->getGain();
+    int part = part_[move_cell_id];
+    part_size_[part] -= graph_.getCellWeight(move_cell_id);
+    part_size_[!part] += graph_.getCellWeight(move_cell_id);
+    removeBucketList(move_cell_id);
+    part_[move_cell_id] = !part;
+    lock_[move_cell_id] = true;
+    acc_gain_ += gain_[move_cell_id];
     ++move_num_;
+    change_move_[move_cell_id] = min(change_move_[move_cell_id], move_num_);
     move_stack_.push_back(move_cell_id);
     if (acc_gain_ > max_acc_gain_) {
         max_acc_gain_  = acc_gain_;
@@ -193,162 +530,351 @@ void Partitioner::moveCell(int move_cell_id) {
 }
 
 void Partitioner::updateGain(int move_cell_id, bool from, bool to) {
-    for (int net_id : cell_array_[move_cell_id]->getNetList()) {
-        Net* net           = net_array_[net_id];
-        auto& net_cell_list = net->getCellList();
+    for (int net_id : graph_.getNetList(move_cell_id)) {
+        IdRange net_cell_list = graph_.getCellList(net_id);
+        if (lookahead_num_) updateLookahead(net_id, from);
+        // Most nets have 2 or 3 pins, they take the written-out kernels unless a cell repeats
+        if (net_cell_list.size() == 2) {
+            updateSmallNet<2>(net_id, move_cell_id, to);
+            continue;
+        }
+        if (net_cell_list.size() == 3 && net_cell_list[0] != net_cell_list[1] && net_cell_list[1] != net_cell_list[2] &&
+            net_cell_list[0] != net_cell_list[2]) {
+            updateSmallNet<3>(net_id, move_cell_id, to);
+            continue;
+        }
+        int net_weight = graph_.getNetWeight(net_id);
         // Before move
-        int to_part_cnt = net->getPartCount(to);
+        int to_part_cnt = partCount(net_id, to);
         if (to_part_cnt == 0) {
             for (int cell_id : net_cell_list) {
-                Cell* cell = cell_array_[cell_id];
-                if (!cell->getLock()) {
-                    updateBucketList(cell, cell->getCLIPGain() + 1);
-                    cell->incGain();
+                if (!lock_[cell_id]) {
+                    updateBucketList(cell_id, getCLIPGain(cell_id) + net_weight);
+                    gain_[cell_id] += net_weight;
                 }
             }
         } else if (to_part_cnt == 1) {
             for (int cell_id : net_cell_list) {
-                Cell* cell = cell_array_[cell_id];
-                if (!cell->getLock() && cell->getPart() == to) {
-                    updateBucketList(cell, cell->getCLIPGain() - 1);
-                    cell->decGain();
+                if (!lock_[cell_id] && part_[cell_id] == to) {
+                    updateBucketList(cell_id, getCLIPGain(cell_id) - net_weight);
+                    gain_[cell_id] -= net_weight;
                 }
             }
         }
 
         // Move base cell
-        net->moveNetCell(to);
+        moveNetCell(net_id, to);
 
         // After move
-        int from_part_cnt = net->getPartCount(from);
+        int from_part_cnt = partCount(net_id, from);
         if (from_part_cnt == 0) {
             for (int cell_id : net_cell_list) {
-                Cell* cell = cell_array_[cell_id];
-                if (!cell->getLock()) {
-                    updateBucketList(cell, cell->getCLIPGain() - 1);
-                    cell->decGain();
+                if (!lock_[cell_id]) {
+                    updateBucketList(cell_id, getCLIPGain(cell_id) - net_weight);
+                    gain_[cell_id] -= net_weight;
                 }
             }
         } else if (from_part_cnt == 1) {
             for (int cell_id : net_cell_list) {
-                Cell* cell = cell_array_[cell_id];
-                if (!cell->getLock() && cell->getPart() == from) {
-                    updateBucketList(cell, cell->getCLIPGain() + 1);
-                    cell->incGain();
+                if (!lock_[cell_id] && part_[cell_id] == from) {
+                    updateBucketList(cell_id, getCLIPGain(cell_id) + net_weight);
+                    gain_[cell_id] += net_weight;
                 }
             }
         }
     }
 }
 
-void Partitioner::updateBucketList(Cell* cell, int clip_gain) {
-    removeBucketList(cell);
-    insertBucketList(cell, clip_gain);
+template <int PinNum>
+void Partitioner::updateSmallNet(int net_id, int move_cell_id, bool to) {
+    // Same updates as the general case of updateGain, in the same order, but decided by the parts of
+    // the other pins instead of scans of the net, so the buckets end up identical
+    IdRange net_cell_list = graph_.getCellList(net_id);
+    int net_weight        = graph_.getNetWeight(net_id);
+    moveNetCell(net_id, to);
+    if constexpr (PinNum == 2) {
+        // The net gets cut if the other cell stays behind, and uncut if it is already in to
+        int cell_id = net_cell_list[net_cell_list[0] == move_cell_id];
+        if (!lock_[cell_id]) shiftGain(cell_id, part_[cell_id] == to ? -2 * net_weight : 2 * net_weight);
+    } else {
+        // a and b are the other cells in net order
+        int move_pos = (net_cell_list[1] == move_cell_id) + 2 * (net_cell_list[2] == move_cell_id);
+        int a        = net_cell_list[move_pos == 0];
+        int b        = net_cell_list[2 - (move_pos == 2)];
+        bool a_to    = part_[a] == to;
+        bool b_to    = part_[b] == to;
+        if (a_to == b_to) {
+            // Both in to: the net gets uncut; both behind: it gets cut
+            int delta = a_to ? -net_weight : net_weight;
+            if (!lock_[a]) shiftGain(a, delta);
+            if (!lock_[b]) shiftGain(b, delta);
+        } else {
+            // The cell in to loses its chance to uncut the net, the one behind becomes its last pin there
+            int to_cell   = a_to ? a : b;
+            int from_cell = a_to ? b : a;
+            if (!lock_[to_cell]) shiftGain(to_cell, -net_weight);
+            if (!lock_[from_cell]) shiftGain(from_cell, net_weight);
+        }
+    }
 }
 
-void Partitioner::insertBucketList(Cell* cell, int clip_gain) {
-    Node* cell_node    = cell->getNode();
-    bool part          = cell->getPart();
-    Node*& bucket_node = blist_[part][getBlistId(clip_gain)];
+void Partitioner::updateBucketList(int cell_id, int clip_gain) {
+    change_move_[cell_id] = min(change_move_[cell_id], move_num_);
+    removeBucketList(cell_id);
+    insertBucketList(cell_id, clip_gain);
+}
+
+void Partitioner::insertBucketList(int cell_id, int clip_gain) {
+    bool part    = part_[cell_id];
+    int blist_id = getBlistId(clip_gain);
+    int head     = getHead(part, blist_id);
     // Insert to the front of the bucket list
-    // Check if the bucket is empty
-    if (!bucket_node) {
-        bucket_node = cell_node;
-    } else {
-        cell_node->setNext(bucket_node);
-        bucket_node->setPrev(cell_node);
-        bucket_node = cell_node;
+    prev_[cell_id]      = head;
+    next_[cell_id]      = next_[head];
+    prev_[next_[head]]  = cell_id;
+    next_[head]         = cell_id;
+    max_blist_id_[part] = max(max_blist_id_[part], blist_id);
+    blist_bit_[part][blist_id / 64] |= uint64_t(1) << (blist_id % 64);
+    blist_word_bit_[part][blist_id / 4096] |= uint64_t(1) << (blist_id / 64 % 64);
+}
+
+void Partitioner::removeBucketList(int cell_id) {
+    next_[prev_[cell_id]] = next_[cell_id];
+    prev_[next_[cell_id]] = prev_[cell_id];
+    // Clear the occupancy bit if the cell emptied its bucket
+    bool part    = part_[cell_id];
+    int blist_id = getBlistId(getCLIPGain(cell_id));
+    int head     = getHead(part, blist_id);
+    if (next_[head] != head) return;
+    uint64_t& word = blist_bit_[part][blist_id / 64];
+    word &= ~(uint64_t(1) << (blist_id % 64));
+    if (!word) blist_word_bit_[part][blist_id / 4096] &= ~(uint64_t(1) << (blist_id / 64 % 64));
+    // Update the highest non-empty bucket
+    if (blist_id == max_blist_id_[part]) max_blist_id_[part] = findMaxBlistId(part);
+}
+
+int Partitioner::findMaxBlistId(bool part) {
+    // Only one summary word is scanned unless there are more than 4096 buckets
+    auto& word_bit = blist_word_bit_[part];
+    for (int i = word_bit.size() - 1; i >= 0; --i) {
+        ++scan_num_;
+        if (!word_bit[i]) continue;
+        int word_id = i * 64 + 63 - __builtin_clzll(word_bit[i]);
+        return word_id * 64 + 63 - __builtin_clzll(blist_bit_[part][word_id]);
     }
+    return -1;
+}
 
-    // Update Max Gain pointer
-    if (!max_clip_gain_cell_[part] || clip_gain >= cell_array_[max_clip_gain_cell_[part]->getId()]->getCLIPGain())
-        max_clip_gain_cell_[part] = cell_node;
+void Partitioner::reportPass(int init_cut, int max_acc_gain, int best_move_num, int move_num, long scan_num, double time_ms) const {
+    // Format the line first, so lines of concurrent starts never interleave
+    stringstream line;
+    line << "{\"start\":" << start_ << ",\"cells\":" << graph_.getCellNum() << ",\"pass\":" << pass_num_ << ",\"init_cut\":" << init_cut
+         << ",\"max_acc_gain\":" << max_acc_gain << ",\"best_move_num\":" << best_move_num << ",\"moves\":" << move_num
+         << ",\"scan_steps\":" << scan_num << ",\"time_ms\":" << time_ms << "}\n";
+    lock_guard<mutex> lock(telemetry_mutex_);
+    *telemetry_ << line.str();
 }
 
-void Partitioner::removeBucketList(Cell* cell) {
-    Node* cell_node = cell->getNode();
-    // The cell to be removed is in the middle of the bucket list
-    if (cell_node->getPrev()) {
-        cell_node->getPrev()->setNext(cell_node->getNext());
-        // The cell to be removed is at the front of the bucket list
-    } else {
-        bool part                         = cell->getPart();
-        int clip_gain                     = cell->getCLIPGain();
-        auto& blist_part                  = blist_[part];
-        blist_part[getBlistId(clip_gain)] = cell_node->getNext();
-        // Update Max Gain pointer
-        if (max_clip_gain_cell_[part] == cell_node) {
-            max_clip_gain_cell_[part] = nullptr;
-            for (auto it = blist_part.rbegin() + (blist_part.size() - 1 - getBlistId(clip_gain)); it != blist_part.rend(); ++it) {
-                if (*it) {
-                    max_clip_gain_cell_[part] = *it;
-                    break;
+void Partitioner::jetRefine() {
+    // Jet-style refinement in rounds, each phase runs on slices of cells in parallel:
+    // 1. every free cell takes its gain, the cells gaining or losing little become candidates
+    // 2. afterburner: each candidate recomputes its gain as if the candidates ranked before it
+    //    (higher gain, then lower id) had moved, and stays a move if it still does not lose
+    // 3. the moves are applied at once, their cells are locked for the next round, the net counts
+    //    are recounted and an unbalanced result is repaired by the heavy part's best cells
+    // The best balanced solution is kept, so the result never gets worse than the start.
+    int cell_num  = graph_.getCellNum();
+    int slice_num = getSliceNum(cell_num, config_.pass_thread_num);
+    vector<char> candidate(cell_num, 0), keep(cell_num, 0);
+    vector<char> best_part(part_);
+    vector<int> size_delta(slice_num), move_count(slice_num);
+    int best_cut  = isBalanced() ? cut_size_ : INT32_MAX;
+    int stall_cut = best_cut;
+    fill(lock_.begin(), lock_.end(), 0);
+    for (int stall_num = 0; stall_num < jet_stall_num && !isTimeOut();) {
+        auto round_begin = chrono::steady_clock::now();
+        int init_cut     = cut_size_;
+        parallelFor(cell_num, slice_num, [&](int, int begin, int end) {
+            for (int cell_id = begin; cell_id < end; ++cell_id) {
+                candidate[cell_id] = false;
+                if (fixed_[cell_id] || lock_[cell_id]) continue;
+                bool part = part_[cell_id];
+                int gain = 0, degree = 0;
+                for (int net_id : graph_.getNetList(cell_id)) {
+                    int net_weight = graph_.getNetWeight(net_id);
+                    degree += net_weight;
+                    if (partCount(net_id, part) == 1)
+                        gain += net_weight;
+                    else if (partCount(net_id, !part) == 0)
+                        gain -= net_weight;
+                }
+                gain_[cell_id]     = gain;
+                candidate[cell_id] = gain >= 0 || -gain < jet_filter * degree;
+            }
+        });
+        parallelFor(cell_num, slice_num, [&](int, int begin, int end) {
+            for (int cell_id = begin; cell_id < end; ++cell_id) {
+                keep[cell_id] = false;
+                if (!candidate[cell_id]) continue;
+                bool part = part_[cell_id];
+                int gain  = 0;
+                for (int net_id : graph_.getNetList(cell_id)) {
+                    // Pins of the net besides this cell in its part and in the other one, after the moves ranked before
+                    int from_num = 0, to_num = 0;
+                    for (int other_id : graph_.getCellList(net_id)) {
+                        if (other_id == cell_id) continue;
+                        bool moved = candidate[other_id] &&
+                                     (gain_[other_id] > gain_[cell_id] || (gain_[other_id] == gain_[cell_id] && other_id < cell_id));
+                        if ((part_[other_id] != moved) == part)
+                            ++from_num;
+                        else
+                            ++to_num;
+                        if (from_num && to_num) break;
+                    }
+                    gain += graph_.getNetWeight(net_id) * ((to_num > 0) - (from_num > 0));
                 }
+                keep[cell_id] = gain >= 0;
             }
+        });
+        parallelFor(cell_num, slice_num, [&](int slice, int begin, int end) {
+            size_delta[slice] = move_count[slice] = 0;
+            for (int cell_id = begin; cell_id < end; ++cell_id) {
+                lock_[cell_id] = keep[cell_id];
+                if (!keep[cell_id]) continue;
+                part_[cell_id] = !part_[cell_id];
+                size_delta[slice] += part_[cell_id] ? graph_.getCellWeight(cell_id) : -graph_.getCellWeight(cell_id);
+                ++move_count[slice];
+            }
+        });
+        int delta = accumulate(size_delta.begin(), size_delta.end(), 0);
+        part_size_[1] += delta;
+        part_size_[0] -= delta;
+        recountNets();
+        if (!isBalanced()) jetRebalance();
+
+        if (isBalanced() && cut_size_ < best_cut) {
+            best_cut  = cut_size_;
+            best_part = part_;
+        }
+        if (best_cut < stall_cut && (stall_cut == INT32_MAX || best_cut < 0.999 * stall_cut)) {
+            stall_cut = best_cut;
+            stall_num = 0;
+        } else {
+            ++stall_num;
+        }
+        ++pass_num_;
+        // A round reports its moves as both the pass length and the kept prefix, the FM state is left alone
+        if (telemetry_) {
+            int move_num = accumulate(move_count.begin(), move_count.end(), 0);
+            reportPass(init_cut, init_cut - cut_size_, move_num, move_num, 0,
+                       chrono::duration<double, milli>(chrono::steady_clock::now() - round_begin).count());
         }
     }
-    if (cell_node->getNext()) cell_node->getNext()->setPrev(cell_node->getPrev());
-    cell_node->setPrev(nullptr);
-    cell_node->setNext(nullptr);
+    if (best_cut != INT32_MAX) part_ = best_part;
+    initPartCount();
+}
+
+void Partitioner::jetRebalance() {
+    // The light part takes the cells of the heavy part by decreasing gain until it meets its lower bound
+    for (int part = 0; part < 2; ++part) {
+        if (part_size_[part] >= getLowerBound(part)) continue;
+        bool heavy = !part;
+        vector<int> cells;
+        for (int cell_id = 0; cell_id < graph_.getCellNum(); ++cell_id) {
+            if (!fixed_[cell_id] && part_[cell_id] == heavy) cells.push_back(cell_id);
+        }
+        parallelFor(cells.size(), getSliceNum(cells.size(), config_.pass_thread_num), [&](int, int begin, int end) {
+            for (int i = begin; i < end; ++i) { gain_[cells[i]] = calcGain(cells[i]); }
+        });
+        stable_sort(cells.begin(), cells.end(), [&](int a, int b) { return gain_[a] > gain_[b]; });
+        for (int cell_id : cells) {
+            if (part_size_[part] >= getLowerBound(part)) break;
+            if (part_size_[heavy] - graph_.getCellWeight(cell_id) < getLowerBound(heavy)) continue;
+            part_[cell_id] = part;
+            part_size_[part] += graph_.getCellWeight(cell_id);
+            part_size_[heavy] -= graph_.getCellWeight(cell_id);
+        }
+        recountNets();
+    }
+}
+
+void Partitioner::recountNets() {
+    // Part counts and cut from scratch, each slice of nets sums its own cut
+    int slice_num = getSliceNum(graph_.getNetNum(), config_.pass_thread_num);
+    vector<int> cut_size(slice_num, 0);
+    parallelFor(graph_.getNetNum(), slice_num, [&](int slice, int begin, int end) {
+        for (int net_id = begin; net_id < end; ++net_id) {
+            int count[2] = {0, 0};
+            for (int cell_id : graph_.getCellList(net_id)) { ++count[bool(part_[cell_id])]; }
+            partCount(net_id, 0) = count[0];
+            partCount(net_id, 1) = count[1];
+            if (count[0] && count[1]) cut_size[slice] += graph_.getNetWeight(net_id);
+        }
+    });
+    cut_size_ = accumulate(cut_size.begin(), cut_size.end(), 0);
+}
+
+void Partitioner::project(const Partitioner& coarse, const vector<int>& cluster_id) {
+    for (int cell_id = 0; cell_id < graph_.getCellNum(); ++cell_id) {
+        part_[cell_id] = coarse.part_[cluster_id[cell_id]];
+    }
+    initPartCount();
 }
 
 void Partitioner::printSummary() const {
     cout << "\n";
     cout << "==================== Summary ====================" << "\n";
     cout << " Cutsize: " << cut_size_ << "\n";
-    cout << " Total cell number: " << cell_num_ << "\n";
-    cout << " Total net number:  " << all_net_num_ << "\n";
+    cout << " Total cell number: " << graph_.getCellNum() << "\n";
+    cout << " Total net number:  " << graph_.getAllNetNum() << "\n";
     cout << " Cell Number of partition A: " << part_size_[0] << "\n";
     cout << " Cell Number of partition B: " << part_size_[1] << "\n";
+    if (deadline_) cout << " Time limit: " << (deadline_->isCutOff() ? "cut off" : "converged") << "\n";
+    if (config_.early_move_num || config_.early_gain_drop)
+        cout << " Early exit: " << early_skip_num_ << " unmoved cells in " << pass_num_ << " passes\n";
+    if (!isBalanced()) cout << " Balance: violated, no balanced split was found for these cell weights\n";
     cout << "=================================================" << "\n";
     cout << "\n";
     return;
 }
 
-void Partitioner::reportNet() const {
-    // This function will not report single-pin nets
-    cout << "Number of nets: " << net_num_ << "\n";
-    for (Net* net : net_array_) {
-        cout << setw(8) << net->getName() << ": ";
-        for (int cell_id : net->getCellList()) { cout << setw(8) << cell_array_[cell_id]->getName() << " "; }
-        cout << "\n";
+void Partitioner::writeResult(ResultWriter& writer) {
+    // One pass over the cells: the names of A(0) go straight to the writer,
+    // the ones of B(1) wait in a second buffer until G1 is complete
+    string part_b_names;
+    writer.append("Cutsize = ");
+    writer.appendNumber(cut_size_);
+    writer.append("\nG1 ");
+    writer.appendNumber(part_size_[0]);
+    writer.append('\n');
+    for (int cell_id = 0; cell_id < graph_.getCellNum(); ++cell_id) {
+        if (part_[cell_id] == 0) {
+            writer.append(graph_.getCellName(cell_id));
+            writer.append(' ');
+        } else {
+            part_b_names.append(graph_.getCellName(cell_id));
+            part_b_names.push_back(' ');
+        }
     }
+    writer.append(";\nG2 ");
+    writer.appendNumber(part_size_[1]);
+    writer.append('\n');
+    writer.append(part_b_names);
+    writer.append(";\n");
+    writer.flush();
     return;
 }
 
-void Partitioner::reportCell() const {
-    cout << "Number of cells: " << cell_num_ << "\n";
-    for (Cell* cell : cell_array_) {
-        cout << setw(8) << cell->getName() << ": ";
-        for (int net_id : cell->getNetList()) { cout << setw(8) << net_array_[net_id]->getName() << " "; }
-        cout << "\n";
+void Partitioner::writePartFile(ResultWriter& writer) {
+    // hMETIS partition file: the part of each vertex, one line per vertex in input order
+    vector<char> vertex_part(graph_.getCellNum());
+    for (int cell_id = 0; cell_id < graph_.getCellNum(); ++cell_id) { vertex_part[graph_.getHgrVertex(cell_id)] = part_[cell_id]; }
+    for (char part : vertex_part) {
+        writer.append(char('0' + part));
+        writer.append('\n');
     }
+    writer.flush();
     return;
 }
 
-void Partitioner::writeResult(fstream& outFile) {
-    stringstream buff;
-    buff << cut_size_;
-    outFile << "Cutsize = " << buff.str() << '\n';
-    buff.str("");
-    buff << part_size_[0];
-    outFile << "G1 " << buff.str() << '\n';
-    for (Cell* cell : cell_array_) {
-        if (cell->getPart() == 0) { outFile << cell->getName() << " "; }
-    }
-    outFile << ";\n";
-    buff.str("");
-    buff << part_size_[1];
-    outFile << "G2 " << buff.str() << '\n';
-    for (Cell* cell : cell_array_) {
-        if (cell->getPart() == 1) { outFile << cell->getName() << " "; }
-    }
-    outFile << ";\n";
-    return;
-}
-
-Partitioner::~Partitioner() {
-    for (Cell* cell : cell_array_) { delete cell; }
-    for (Net* net : net_array_) { delete net; }
-    return;
-}
+Partitioner::~Partitioner() {}
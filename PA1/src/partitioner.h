@@ -1,50 +1,98 @@
 #ifndef PARTITIONER_H
 #define PARTITIONER_H
 
-#include <fstream>
-#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <random>
 
-#include "cell.h"
-#include "net.h"
+#include "config.h"
+#include "deadline.h"
+#include "hypergraph.h"
+#include "result_writer.h"
 using namespace std;
 
 class Partitioner {
   public:
     // constructor and destructor
-    Partitioner(fstream& in_file) : cut_size_(0), net_num_(0), all_net_num_(0), cell_num_(0), b_factor_(0), part_size_{0, 0} {
-        parseInput(in_file);
+    // The bisection keeps part A(0) at ratio of the total weight, within the balance factor b_factor,
+    // config holds the options of the call, deadline is its time limit, nullptr if none
+    Partitioner(const Hypergraph& graph, double b_factor, double ratio, Config config = Config(), int start = 0, Deadline* deadline = nullptr)
+        : graph_(graph), b_factor_(b_factor), ratio_(ratio), config_(config), start_(start), deadline_(deadline), cut_size_(0), part_size_{0, 0},
+          best_move_num_(0), pass_num_(0), early_skip_num_(0), scan_num_(0), rng_(config.seed + start) {
         initPartition();
     }
     ~Partitioner();
 
     // modify method
-    void parseInput(fstream& in_file);
-    void partition();
+    void run();
+    // FM stops after max_pass_num passes (0 for no limit) or after a pass gaining less than min_gain_ratio
+    // of its starting cut, and at convergence anyway; Jet has its own stopping rule
+    void refine(int max_pass_num = 0, double min_gain_ratio = 0);
+    void partition(int max_pass_num = 0, double min_gain_ratio = 0);
+    void jetRefine();
+    void multilevelPartition();
+    void seedPartition(const vector<int>& cell_part, bool fix_known);
+    // Fix each cell with cell_part 0 or 1 in that part, -1 leaves it free; multilevelPartition() then refines flat
+    void fixCells(const vector<int>& cell_part);
+    // config.start_num starts on config.thread_num threads, the best one is returned
+    static Partitioner* multiStartPartition(const Hypergraph& graph, double b_factor, double ratio, Config config, Deadline* deadline = nullptr);
+    static void setTelemetry(ostream* telemetry) { telemetry_ = telemetry; }
+
+    // basic access methods
+    int getCutSize() const { return cut_size_; }
+    bool getPart(int cell_id) const { return part_[cell_id]; }
+    const vector<char>& getParts() const { return part_; }
+    // Whether both parts meet their lower bound
+    bool isBalanced() const { return part_size_[0] >= getLowerBound(0) && part_size_[1] >= getLowerBound(1); }
 
     // member functions about reporting
     void printSummary() const;
-    void reportNet() const;
-    void reportCell() const;
-    void writeResult(fstream& out_file);
+    void writeResult(ResultWriter& writer);
+    void writePartFile(ResultWriter& writer);
 
   private:
     // Input data
-    int net_num_;                                // number of non-single-pin nets
-    int all_net_num_;                            // number of all nets
-    int cell_num_;                               // number of cells
-    double b_factor_;                            // the balance factor to be met
-    vector<Net*> net_array_;                     // net array of the circuit
-    vector<Cell*> cell_array_;                   // cell array of the circuit
-    unordered_map<string, int> cell_name_2_id_;  // mapping from cell name to id
+    const Hypergraph& graph_;  // the shared read-only hypergraph
+    double b_factor_;          // the balance factor to be met
+    double ratio_;             // target weight ratio of partition A(0)
+    Config config_;            // options of the call
+    int start_;                // index of this start, 0 is the deterministic one
+    Deadline* deadline_;       // time limit shared by the partitioners of the call, nullptr if none
+
+    // Cell and net states, indexed by id
+    vector<int> gain_;         // real gain of each cell
+    vector<int> init_gain_;    // initial gain of each cell in a pass, for CLIP
+    vector<char> part_;        // partition each cell belongs to (A(0) or B(1))
+    vector<char> lock_;        // whether each cell is locked
+    vector<char> fixed_;       // whether each cell is fixed in its partition, it is never moved
+    vector<int> part_count_;   // cell number of each net in A(0) and B(1), two entries per net
+    vector<int> change_move_;  // first move of the pass changing the gain of each cell, INT32_MAX if none
+
+    // Lookahead gains (Krishnamurthy), kept only if config_.lookahead is set
+    int lookahead_num_;           // levels kept per cell: 1 for level 2, 2 for levels 2 and 3, 0 if disabled
+    vector<int> lookahead_gain_;  // level-2 (and level-3) gain of each cell, lookahead_num_ entries per cell
 
     // Partition solution
     int cut_size_;      // cut size
-    int part_size_[2];  // size (cell number) of partition A(0) and B(1)
+    int part_size_[2];  // size (cell weight) of partition A(0) and B(1)
 
     // Bucket list data structure
-    int blist_offset_;             // offset of bucket list
-    Node* max_clip_gain_cell_[2];  // pointer to max CLIP gain cell node
-    vector<Node*> blist_[2];       // bucket list of partition A(0) and B(1)
+    // Cells and bucket heads share the link arrays: node cell_num + part * blist_size_ + blist_id
+    // is the sentinel head of a circular bucket list, so linking a cell in or out never branches
+    int blist_offset_;     // offset of bucket list
+    int blist_size_;       // number of buckets of a partition
+    int max_blist_id_[2];  // highest non-empty bucket of partition A(0) and B(1), -1 if all are empty
+    vector<int> prev_;     // previous node of each node in its bucket list
+    vector<int> next_;     // next node of each node in its bucket list
+
+    // Two-level occupancy bitmap of the buckets: bit b of blist_bit_ is set if bucket b is
+    // non-empty, and bit w of blist_word_bit_ is set if word w of blist_bit_ is non-zero
+    vector<uint64_t> blist_bit_[2];
+    vector<uint64_t> blist_word_bit_[2];
 
     // Algorithm data
     int acc_gain_;            // accumulative gain
@@ -52,18 +100,68 @@ class Partitioner {
     int move_num_;            // number of cell movements
     int best_move_num_;       // store move_num_ when max_acc_gain_ occurs
     vector<int> move_stack_;  // history of cell movement
+    vector<int> clip_order_;  // cells sorted by decreasing initial gain, for CLIP
+    vector<int> gain_count_;  // counting sort buffer of clip_order_, one entry per initial gain and slice of cells
+    int pass_num_;            // number of passes
+    long early_skip_num_;     // number of cells left unmoved by early exits
+    long scan_num_;           // number of summary words scanned for the max bucket in a pass
+
+    // Telemetry: one JSON line per pass, shared by all partitioners, nullptr if disabled
+    static ostream* telemetry_;
+    static mutex telemetry_mutex_;
+
+    // Multilevel data
+    mt19937 rng_;  // random generator for the initial partition and the matching order
 
     // Partitioner methods
     void initPartition();
+    void initPartCount();
+    void streamPartition();
+    void balanceParts();
+    void jetRebalance();
+    void recountNets();
+    int calcGain(int cell_id);
+    void calcLookahead(int cell_id);
+    void updateLookahead(int net_id, bool from);
+    int getMoveCell(bool part) const;
     void initPass();
     void moveCell(int cell_id);
     void updateGain(int cell_id, bool from, bool to);
-    void updateBucketList(Cell* cell, int clip_gain);
-    void insertBucketList(Cell* cell, int clip_gain);
-    void removeBucketList(Cell* cell);
+    template <int PinNum>
+    void updateSmallNet(int net_id, int move_cell_id, bool to);
+    void updateBucketList(int cell_id, int clip_gain);
+    void insertBucketList(int cell_id, int clip_gain);
+    void removeBucketList(int cell_id);
+    int findMaxBlistId(bool part);
+    void reportPass(int init_cut, int max_acc_gain, int best_move_num, int move_num, long scan_num, double time_ms) const;
+    bool isTimeOut() const { return deadline_ && deadline_->isTimeOut(); }
+
+    // Multilevel methods
+    void project(const Partitioner& coarse, const vector<int>& cluster_id);
+
+    // Cell and net state access methods
+    int getCLIPGain(int cell_id) const { return gain_[cell_id] - init_gain_[cell_id]; }
+    void shiftGain(int cell_id, int delta) {
+        updateBucketList(cell_id, getCLIPGain(cell_id) + delta);
+        gain_[cell_id] += delta;
+    }
+    int& partCount(int net_id, bool part) { return part_count_[2 * net_id + part]; }
+    void moveNetCell(int net_id, bool to_part) {
+        ++partCount(net_id, to_part);
+        --partCount(net_id, !to_part);
+    }
+    void moveNetCellAtomic(int net_id, bool to_part) {
+        __atomic_add_fetch(&partCount(net_id, to_part), 1, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&partCount(net_id, !to_part), 1, __ATOMIC_RELAXED);
+    }
+
+    // Balance: the minimum size (cell weight) of a partition
+    int getLowerBound(bool part) const { return ceil((1 - b_factor_) * graph_.getTotalWeight() * (part ? 1 - ratio_ : ratio_)); }
 
     // Index conversion methods for bucket list
-    int getBlistId(int clip_gain) { return clip_gain - blist_offset_; }
+    int getBlistId(int clip_gain) const { return clip_gain - blist_offset_; }
+    int getHead(bool part, int blist_id) const { return graph_.getCellNum() + part * blist_size_ + blist_id; }
+    int getMaxCLIPGainCell(bool part) const { return next_[getHead(part, max_blist_id_[part])]; }
 };
 
-#endif  // PARTITIONER_H
\ No newline at end of file
+#endif  // PARTITIONER_H
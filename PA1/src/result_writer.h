@@ -0,0 +1,66 @@
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include <charconv>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+using namespace std;
+
+// Buffered writer of the result file: the text is gathered in a large reusable buffer and written
+// in bulk, by a background thread if async, so the output overlaps with whatever runs next
+class ResultWriter {
+  public:
+    // constructor and destructor
+    ResultWriter(ostream& out_file, bool async, size_t buffer_size = 1 << 20) : out_file_(out_file), async_(async), buffer_size_(buffer_size) {
+        buffer_.reserve(buffer_size);
+        writing_.reserve(buffer_size);
+    }
+    ResultWriter(const ResultWriter&)            = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+    ~ResultWriter() { close(); }
+
+    // modify methods
+    void append(string_view str) {
+        if (buffer_.size() + str.size() > buffer_size_) flush();
+        buffer_.append(str);
+    }
+    void append(char c) {
+        if (buffer_.size() + 1 > buffer_size_) flush();
+        buffer_.push_back(c);
+    }
+    void appendNumber(long value) {
+        char str[24];
+        append(string_view(str, to_chars(str, str + sizeof(str), value).ptr - str));
+    }
+    // Hand the buffer to the output, the previous background write is waited for first
+    void flush() {
+        wait();
+        swap(buffer_, writing_);
+        buffer_.clear();
+        if (async_)
+            thread_ = thread([this]() { out_file_.write(writing_.data(), writing_.size()); });
+        else
+            out_file_.write(writing_.data(), writing_.size());
+    }
+    // Write everything out and wait for it
+    void close() {
+        if (!buffer_.empty()) flush();
+        wait();
+    }
+
+  private:
+    void wait() {
+        if (thread_.joinable()) thread_.join();
+    }
+
+    ostream& out_file_;   // the result file
+    bool async_;          // whether the bulk writes run on a background thread
+    size_t buffer_size_;  // size of a bulk write
+    string buffer_;       // text being gathered
+    string writing_;      // text being written
+    thread thread_;       // background thread of the last bulk write
+};
+
+#endif  // RESULT_WRITER_H